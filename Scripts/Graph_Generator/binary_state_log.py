@@ -0,0 +1,68 @@
+# Reads the binary state log written by the simulator with --binary-log
+# (see src/model/binary_state_log.hpp for the layout of the file)
+
+import math
+import struct
+import sys
+
+MAGIC = b"SEVIRDSL"
+VERSION = 1
+
+
+def read_binary_state_log(path):
+    """
+    Returns (fields, cells, days) where fields are the names of the columns, cells the IDs of the cells and days
+    a list of (time, records) with records a list of (cell index, [values]) in the order they were logged.
+    The first day holds the initial states of the cells and its time is None.
+    """
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if data[:8] != MAGIC:
+        raise ValueError(path + " is not a binary state log")
+
+    version, byte_order, value_size, num_fields, num_cells, num_days, table_offset = struct.unpack_from("<6IQ", data, 8)
+    if version != VERSION or byte_order != 0x01020304:
+        raise ValueError(path + " was written by another version of the simulator or on a machine with another byte order")
+
+    position = 8 + struct.calcsize("<6IQ")
+
+    def read_strings(count):
+        nonlocal position
+        strings = []
+        for _ in range(count):
+            length, = struct.unpack_from("<I", data, position)
+            strings.append(data[position + 4:position + 4 + length].decode())
+            position += 4 + length
+        return strings
+
+    fields = read_strings(num_fields)
+    cells  = read_strings(num_cells)
+    value_format = "f" if value_size == 4 else "d"
+
+    days = []
+    for day in range(num_days):
+        time, offset, count = struct.unpack_from("<dQI", data, table_offset + day * struct.calcsize("<dQI"))
+
+        cell_indices = struct.unpack_from("<%dI" % count, data, offset + 4 * count)
+        columns = []
+        for field in range(num_fields):
+            start = offset + 8 * count + field * value_size * count
+            columns.append(struct.unpack_from("<%d%s" % (count, value_format), data, start))
+
+        records = [(cell_indices[r], [column[r] for column in columns]) for r in range(count)]
+        days.append((None if math.isnan(time) else time, records))
+
+    return fields, cells, days
+
+
+if __name__ == '__main__':
+    # Prints the log in the format of pandemic_state.txt
+    fields, cells, days = read_binary_state_log(sys.argv[1])
+
+    for time, records in days:
+        if time is not None:
+            print("%g" % time)
+
+        for cell, values in records:
+            print("State for model _%s is <%s>" % (cells[cell], ",".join("%g" % v for v in values)))
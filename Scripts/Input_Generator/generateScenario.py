@@ -59,6 +59,7 @@ infectedCells = json.loads( open(input_dir + "/infectedCell.json", "r").read() )
 default_state              = default_cell["default"]["state"]
 default_vicinity           = default_cell["default"]["neighborhood"]["default_cell_id"]
 default_correction_factors = default_vicinity["infection_correction_factors"]
+default_profile            = "default" # Every vicinity shares the default correction factors through this profile
 default_correlation        = default_vicinity["correlation"]
 
 nan_rows           = df[ df[population].isnull() ]
@@ -95,7 +96,7 @@ for ind, row, in df_adj.iterrows():
     if correlation == 0:
         continue
 
-    expr = {"correlation": correlation, "infection_correction_factors": default_correction_factors}
+    expr = {"correlation": correlation, "infection_correction_factors": default_profile}
     adj_full[row_region_id_str][row_region_id_str]["neighborhood"][row_neighborhood_id_str]=expr
 
     if not(no_progress) and ind % progress_freq == 0:
@@ -105,7 +106,7 @@ for ind, row, in df_adj.iterrows():
 
 for key, value in adj_full.items():
     # Insert every cell into its own neighborhood, a cell is -> cell = adj_full[key][key]
-    adj_full[key][key]["neighborhood"][key] = {"correlation": default_correlation, "infection_correction_factors": default_correction_factors}
+    adj_full[key][key]["neighborhood"][key] = {"correlation": default_correlation, "infection_correction_factors": default_profile}
     if not(no_progress):
         progress = (int)(10 * list(adj_full.keys()).index(key)/len(adj_full.items()))
         sys.stdout.write("\r\033[33m" + str(70 + progress) + "%" + "\033[0m")
@@ -113,6 +114,7 @@ for key, value in adj_full.items():
 
 # Insert cells from ordered dictionary into index "cells" of a new OrderedDict
 template = OrderedDict()
+template["correction_profiles"] = {default_profile: default_correction_factors} # Must come before the cells
 template["cells"] = {}
 template["cells"]["default"] = default_cell["default"]
 
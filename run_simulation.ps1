@@ -75,6 +75,18 @@ param(
     # Turns off progress and loading animations
     [switch]$NoProgress = $False,
 
+    # Cells send a summary of their state to their neighbors (needs -Csr or -Threads)
+    [switch]$Compact = $False,
+
+    # Runs the model with the synchronous CSR engine instead of Cadmium
+    [switch]$Csr = $False,
+
+    # Writes the logs from background threads
+    [switch]$AsyncLog = $False,
+
+    # Computes the cells of each day on this many threads instead of using the Cadmium runner (default=off)
+    [int32]$Threads = 0,
+
     # Re-Compiles the simulator
     [switch]$Rebuild = $False,
 
@@ -89,7 +101,7 @@ param(
 ) #params()
 
 # Check if any of the above params were set
-$private:Params        = "Config", "Clean", "Days", "GenScenario", "GraphPerRegions", "GenRegionGraphs", "Name", "NoProgress", "Rebuild", "FullRebuild", "DebugSim", "Export"
+$private:Params        = "Config", "Clean", "Days", "GenScenario", "GraphPerRegions", "GenRegionGraphs", "Name", "NoProgress", "Compact", "Csr", "AsyncLog", "Threads", "Rebuild", "FullRebuild", "DebugSim", "Export"
 $private:ParamsNotNull = $False
 foreach($Param in $Params) { if ($PSBoundParameters.keys -like "*"+$Param+"*") { $ParamsNotNull = $True; break; } }
 
@@ -479,7 +491,10 @@ function Main()
     # Run simulation
     Set-Location bin
     Write-Output "`nExecuting model for $Days days:"
-    .\pandemic-geographical_model.exe ..\config\scenario_${Config}.json $Days $Progress
+    $private:Model = (($Csr) ? ".\pandemic-geographical_model-csr.exe" : ".\pandemic-geographical_model.exe")
+    # The parallel runner and the CSR engine write the GIS Viewer files themselves
+    $private:ViewerArgs = (($Csr -or $Threads -gt 0) ? @("--viewer-log", "..\$VisualizationDir") : @())
+    & $Model ..\config\scenario_${Config}.json $Days $Progress @ThreadArgs @ViewerArgs
     ErrorCheck
     Set-Location $HomeDir
     Write-Output "" # Print new line
@@ -491,7 +506,7 @@ function Main()
     # But this will change at some point
     try { $private:Version = java --version }
     catch { $Version = "" }
-    if ( ($Version -clike "*java 16*") ) {
+    if ( !$ViewerArgs -and ($Version -clike "*java 16*") ) {
         if ( !(Test-Path .\Scripts\Msg_Log_Parser\input)  ) { New-Item .\Scripts\Msg_Log_Parser\input  -ItemType Directory | Out-Null }
         if ( !(Test-Path .\Scripts\Msg_Log_Parser\output) ) { New-Item .\Scripts\Msg_Log_Parser\output -ItemType Directory | Out-Null }
         Copy-Item config\scenario_${Config}.json .\Scripts\Msg_Log_Parser\input
@@ -519,7 +534,7 @@ function Main()
     ComputeBuildTime $True $Stopwatch
 
     Write-Host -NoNewline "View results using the files in ${BOLD}${BLUE}${VisualizationDir}${RESET}"
-    if ( ($Version -clike "*java 16*") ) {
+    if ( $ViewerArgs -or ($Version -clike "*java 16*") ) {
         Write-Host " and through the web viewer: ${BOLD}${BLUE}http://206.12.94.204:8080/arslab-web/1.3/app-gis-v2/index.html${RESET}"
     } else { Write-Host "" }
     Quit
@@ -528,6 +543,9 @@ function Main()
 if ($ParamsNotNull) {
     # Setup global variables
     $Script:Progress  = (($NoProgress) ? "-np" : "")
+    $Script:ThreadArgs = (($Threads -gt 0) ? @("--threads", $Threads) : @())
+    if ($Compact) { $Script:ThreadArgs += "--compact" }
+    if ($AsyncLog) { $Script:ThreadArgs += "--async-log" }
     $local:BuildType  = (($DebugSim) ? "Debug" : "Release")
     $local:Verbose    = (($VerbosePreference -eq "SilentlyContinue" ? "N" : "Y"))
     $Script:InvokeDir = Get-Location | Select-Object -ExpandProperty Path
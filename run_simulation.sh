@@ -138,7 +138,10 @@
         if [[ $1 == 1 ]]; then
             echo -e "${YELLOW}Flags:${RESET}"
             echo -e " ${YELLOW}--area=*|-a=*${RESET} \t\t\t Sets the area to run a simulation on"
+            echo -e " ${YELLOW}--compact${RESET} \t\t\t Cells send a summary of their state to their neighbors (needs --csr or --threads)"
+            echo -e " ${YELLOW}--csr${RESET} \t\t\t\t Runs the model with the synchronous CSR engine instead of Cadmium"
             echo -e " ${YELLOW}--debug|-db${RESET} \t\t\t Compiles the model for debuggging (breakpoints will only bind in debug)"
+            echo -e " ${YELLOW}--async-log${RESET} \t\t\t Writes the logs from background threads"
             echo -e " ${YELLOW}--clean|-c|--clean=*|-c=*${RESET} \t Cleans all simulation runs for the selected area if no # is set, \n \t\t\t\t otherwise cleans the specified run using the folder name inputed such as 'clean=run1'"
             echo -e " ${YELLOW}--days=#|-d=#${RESET} \t\t\t Sets the number of days to run a simulation (default=500)"
             echo -e " ${YELLOW}--flags, -f${RESET}\t\t\t Displays all flags"
@@ -149,6 +152,7 @@
             echo -e " ${YELLOW}--no-progress, -np${RESET}\t\t Turns off the progress bars and loading animations"
             echo -e " ${YELLOW}--profile, -p${RESET}\t\t\t Builds using the ${ITALIC}pg${RESET} profiler tool, runs the model, then exports the results in a text file"
             echo -e " ${YELLOW}--rebuild, -r${RESET}\t\t\t Rebuilds the model"
+            echo -e " ${YELLOW}--threads=#|-t=#${RESET} \t\t Computes the cells of each day on # threads instead of using the Cadmium runner"
             echo -e " ${YELLOW}--valgrind|-v${RESET}\t\t\t Runs using valgrind, a memory error and leak check tool"
             echo -e " ${YELLOW}--Wall|-w${RESET}\t\t\t Displays build warnings"
         else
@@ -264,10 +268,14 @@ Main()
     # Generate scenario
     GenerateScenario
 
+    # The parallel runner and the CSR engine write the GIS Viewer files themselves
+    VIEWER_LOG=""
+    if [[ $THREADS != "" || $MODEL == *"-csr" ]]; then VIEWER_LOG="--viewer-log ../${VISUALIZATION_DIR}"; fi
+
     # Run the model
     cd bin
     echo; echo "Executing Model for $DAYS Days"
-    ./pandemic-geographical_model ../config/scenario_${INPUT_DIR}.json $DAYS $PROGRESS
+    ./${MODEL} ../config/scenario_${INPUT_DIR}.json $DAYS $PROGRESS $THREADS $COMPACT $ASYNC_LOG $VIEWER_LOG
     ErrorCheck $? # Check for build errors
     cd $HOME_DIR
     echo
@@ -275,29 +283,31 @@ Main()
     # Generate SEVIRDS graphs
     GenerateGraphs $GRAPH_REGIONS "Y"
 
-    # Copy the message log + scenario to message log parser's input
-    # Note this deletes the contents of input/output folders of the message log parser before executing
-    mkdir -p Scripts/Msg_Log_Parser/input
-    mkdir -p Scripts/Msg_Log_Parser/output
-    cp config/scenario_${INPUT_DIR}.json Scripts/Msg_Log_Parser/input
-    cp logs/pandemic_messages.txt Scripts/Msg_Log_Parser/input
-    cp logs/pandemic_state.txt Scripts/Msg_Log_Parser/input
-
-    # Run the message log parser
-    echo; echo "Prepping GIS Viewer Files"
-    cd Scripts/Msg_Log_Parser
-    #java -jar sim.converter.glenn.jar "input" "output" > log 2>&1
-    python3 main.py --scenario ./input/scenario_${INPUT_DIR}.json --state ./input/pandemic_state.txt --fields Population Susceptible Exposed VaccinatedD1 VaccinatedD2 Infected Recovered NewExposed NewInfected NewRecovered Deaths VaccinatedB
-    ErrorCheck $? log # Check for build errors
-    #unzip "output\pandemic_messages.zip" -d output
-    cd $HOME_DIR
+    if [[ $VIEWER_LOG == "" ]]; then
+        # Copy the message log + scenario to message log parser's input
+        # Note this deletes the contents of input/output folders of the message log parser before executing
+        mkdir -p Scripts/Msg_Log_Parser/input
+        mkdir -p Scripts/Msg_Log_Parser/output
+        cp config/scenario_${INPUT_DIR}.json Scripts/Msg_Log_Parser/input
+        cp logs/pandemic_messages.txt Scripts/Msg_Log_Parser/input
+        cp logs/pandemic_state.txt Scripts/Msg_Log_Parser/input
+
+        # Run the message log parser
+        echo; echo "Prepping GIS Viewer Files"
+        cd Scripts/Msg_Log_Parser
+        #java -jar sim.converter.glenn.jar "input" "output" > log 2>&1
+        python3 main.py --scenario ./input/scenario_${INPUT_DIR}.json --state ./input/pandemic_state.txt --fields Population Susceptible Exposed VaccinatedD1 VaccinatedD2 Infected Recovered NewExposed NewInfected NewRecovered Deaths VaccinatedB
+        ErrorCheck $? log # Check for build errors
+        #unzip "output\pandemic_messages.zip" -d output
+        cd $HOME_DIR
 
-    # Copy the converted message logs to GIS Web Viewer Folder
-    mv Scripts/Msg_Log_Parser/output/messages.log $VISUALIZATION_DIR
-    mv Scripts/Msg_Log_Parser/output/structure.json $VISUALIZATION_DIR
-    rm -rf Scripts/Msg_Log_Parser/input
-    rm -rf Scripts/Msg_Log_Parser/output
-    rm -f Scripts/Msg_Log_Parser/*.zip
+        # Copy the converted message logs to GIS Web Viewer Folder
+        mv Scripts/Msg_Log_Parser/output/messages.log $VISUALIZATION_DIR
+        mv Scripts/Msg_Log_Parser/output/structure.json $VISUALIZATION_DIR
+        rm -rf Scripts/Msg_Log_Parser/input
+        rm -rf Scripts/Msg_Log_Parser/output
+        rm -f Scripts/Msg_Log_Parser/*.zip
+    fi
     cp cadmium_gis/${AREA}/${AREA}.geojson $VISUALIZATION_DIR
     cp cadmium_gis/${AREA}/visualization.json $VISUALIZATION_DIR
     mv logs $VISUALIZATION_DIR
@@ -315,6 +325,10 @@ else
     PROFILE="N"
     NAME=""
     DAYS="500"
+    THREADS=""
+    COMPACT=""
+    ASYNC_LOG=""
+    MODEL="pandemic-geographical_model"
     GRAPH_REGIONS="N"
     GENERATE="N"
     BUILD_TYPE="Release"
@@ -342,6 +356,18 @@ else
                 CLEAN=Y
                 shift
             ;;
+            --compact)
+                COMPACT="--compact"
+                shift
+            ;;
+            --async-log)
+                ASYNC_LOG="--async-log"
+                shift
+            ;;
+            --csr)
+                MODEL="pandemic-geographical_model-csr"
+                shift
+            ;;
             --days=*|-d=*)
                 if [[ $1 == *"="* ]]; then
                     DAYS=`echo $1 | sed -e 's/^[^=]*=//g'`;
@@ -394,6 +420,12 @@ else
                 rm -rf bin/*
                 shift;
             ;;
+            --threads=*|-t=*)
+                if [[ $1 == *"="* ]]; then
+                    THREADS="--threads `echo $1 | sed -e 's/^[^=]*=//g'`";
+                fi
+                shift
+            ;;
             --valgrind|-val)
                 VALGRIND="valgrind --leak-check=yes -s"
                 shift
@@ -411,7 +443,7 @@ else
     done
 
     # Compile the model if it does not exist
-    if [[ ! -f "bin/pandemic-geographical_model" ]]; then
+    if [[ ! -f "bin/${MODEL}" ]]; then
         DependencyCheck "Y" "N"
 
         echo -e "Building Model ${YELLOW}[Type: ${BLUE}${BUILD_TYPE}${YELLOW} | Wall: ${BLUE}${WALL}${YELLOW}]${RESET}"
@@ -455,7 +487,7 @@ else
             fi
 
             cd bin
-            valgrind --tool=callgrind --dump-instr=yes --simulate-cache=yes --collect-jumps=yes --collect-atstart=no ./pandemic-geographical_model ../config/scenario_${INPUT_DIR}.json $DAYS $PROGRESS
+            valgrind --tool=callgrind --dump-instr=yes --simulate-cache=yes --collect-jumps=yes --collect-atstart=no ./${MODEL} ../config/scenario_${INPUT_DIR}.json $DAYS $PROGRESS $THREADS $COMPACT $ASYNC_LOG
             ErrorCheck $?
             cd $HOME_DIR
             BuildTime "Profiling"
@@ -469,7 +501,7 @@ else
             fi
 
             cd bin
-            $VALGRIND ./pandemic-geographical_model ../config/scenario_${INPUT_DIR}.json $DAYS $PROGRESS
+            $VALGRIND ./${MODEL} ../config/scenario_${INPUT_DIR}.json $DAYS $PROGRESS $THREADS $COMPACT $ASYNC_LOG
             ErrorCheck $?
             cd $HOME_DIR
             BuildTime "Memory Check"
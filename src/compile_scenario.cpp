@@ -0,0 +1,26 @@
+// Converts a json scenario to the binary format of compiled_scenario.hpp.
+// The compiled scenario can then be given to the simulator instead of the json one.
+
+#include <chrono>
+#include <iostream>
+#include "model/compiled_scenario.hpp"
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        cerr << "\033[31mProgram used with wrong parameters. The program must be invoked as follows: "
+            << argv[0] << " SCENARIO_CONFIG.json SCENARIO.bin\33[0m" << endl;
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    unsigned int cells = compiled_scenario::compile(argv[1], argv[2]);
+    auto end = chrono::steady_clock::now();
+
+    cout << "\033[1;32mCompiled " << cells << " cells into " << argv[2] << " in "
+        << chrono::duration_cast<chrono::milliseconds>(end - start).count() << "ms\033[0m" << endl;
+    return 0;
+} //main()
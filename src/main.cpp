@@ -33,6 +33,8 @@
 #include <cadmium/engine/pdevs_dynamic_runner.hpp>
 #include <cadmium/logger/common_loggers.hpp>
 #include "model/geographical_coupled.hpp"
+#include "model/parallel_runner.hpp"
+#include "model/simulation_options.hpp"
 #include <thread>
 #include <chrono>
 
@@ -43,10 +45,12 @@ using namespace cadmium::celldevs;
 using TIME = float;
 
 /*************** Loggers *******************/
-static ofstream out_messages("../logs/pandemic_messages.txt");
-struct oss_sink_messages { static ostream& sink(){ return out_messages; } };
-static ofstream out_state("../logs/pandemic_state.txt");
-struct oss_sink_state { static ostream& sink() { return out_state; } };
+// Point at the text logs of the simulation_outputs when the Cadmium runner is used
+static ostream* messages_sink = nullptr;
+static ostream* state_sink    = nullptr;
+
+struct oss_sink_messages { static ostream& sink(){ return *messages_sink; } };
+struct oss_sink_state { static ostream& sink() { return *state_sink; } };
 
 using state             = logger::logger<logger::logger_state,          dynamic::logger::formatter<TIME>,   oss_sink_state>;
 using log_messages      = logger::logger<logger::logger_messages,       dynamic::logger::formatter<TIME>,   oss_sink_messages>;
@@ -56,47 +60,52 @@ using logger_top        = logger::multilogger<state,                    log_mess
 
 int main(int argc, char** argv)
 {
-    if (argc < 2)
-    {
-        cerr << "\033[31mProgram used with wrong parameters. The program must be invoked as follows: "
-            << argv[0] << " SCENARIO_CONFIG.json [MAX_SIMULATION_TIME (default: 500)]\33[0m" << endl;
-        throw;
-    }
+    simulation_options options(argc, argv);
 
-    // The C++ standard filesystem library is not used as it may require an additional linker flag (-std=c++17),
-    // but more importantly that in certain versions of GCC the filesystem is contained in an experimental folder (GCC 7).
-    // Newer versions of GCC doesn't have this problem (apparently GCC 8+ ?). As a result, depending on the version of GCC
-    // used different code is required, so an older version of code to try to open a file is used.
+    // Number of threads computing the cells, the Cadmium runner is used when it isn't given
+    unsigned int threads = options.threads;
+    if (threads == 0)
+        options.check_cadmium_runner();
+    else
+        options.check_parallel_runner();
 
-    // A check to see if the file exists / can be accessed because the error message the JSON library gives if the
-    // file does not exist is not informative (at the time of this writing).
-    ifstream file_existence_checker{argv[1]};
-
-    if (!file_existence_checker.is_open())
-        throw runtime_error{"Unable to open the file: " + string{argv[1]}};
+    simulation_outputs outputs(options);
 
     // Note: At the time of this writing, the web viewer that consumes the log files of this simulator relies on the
     // the input to geographical_coupled parameter (param name: id) to be empty; this changes how the IDs of cells
     // in the log files are printed.
-    geographical_coupled<TIME> test = geographical_coupled<TIME>("");
-    string scenario_config_file_path = argv[1];
-    test.add_cells_json(scenario_config_file_path);
-    test.couple_cells();
+    geographical_coupled<TIME> test = geographical_coupled<TIME>("", threads > 0);
+    test.add_cells_scenario(options.scenario_path);
+
+    if (threads > 0)
+    {
+        parallel_runner<TIME> r(test, threads, outputs.state_log(), outputs.messages_log(), options.compact);
+        outputs.attach(r, options);
 
-    shared_ptr<cadmium::dynamic::modeling::coupled <TIME>>
-    t = make_shared<geographical_coupled<TIME>>(test);
+        TIME stop_time = r.run_until(options.sim_time);
+        if (options.convergence.reason() != convergence_monitor::NONE)
+            cout << "\r\033[33mStopped after day " << stop_time - 1 << ", " << convergence_monitor::name(options.convergence.reason()) << "\033[0m" << endl;
+    }
+    else
+    {
+        // The loggers flush after every line, that's left to the end of the run
+        unflushed_stream messages(outputs.messages_log()), states(outputs.state_log());
+        messages_sink = &messages;
+        state_sink    = &states;
 
-    // Has the 'no progress' flag been set?
-    bool noProgress = (argc > 3) && strcmp((argv[3]), "-np") == 0;
+        test.couple_cells();
 
-    cadmium::dynamic::engine::runner<TIME, logger_top> r(t, {0});
+        shared_ptr<cadmium::dynamic::modeling::coupled <TIME>>
+        t = make_shared<geographical_coupled<TIME>>(test);
 
-    // Turn on the progress meter
-    if (!noProgress)
-        r.turn_progress_on();
+        cadmium::dynamic::engine::runner<TIME, logger_top> r(t, {0});
 
-    float sim_time = (argc > 2) ? atof(argv[2]) : 500;
-    r.run_until(sim_time);
+        // Turn on the progress meter
+        if (!options.no_progress)
+            r.turn_progress_on();
+
+        r.run_until(options.sim_time);
+    }
 
     // The spaces at the the end are necessary to clear the terminal
     // line that's being overwritten
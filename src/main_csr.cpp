@@ -0,0 +1,55 @@
+// Runs a scenario with the synchronous CSR engine instead of Cadmium.
+// It takes the same arguments and writes the same logs as main.cpp, and with --branches
+// it forks the simulation into the what-if branches of a branch_spec.
+
+#include <fstream>
+#include <iostream>
+#include "model/branch_spec.hpp"
+#include "model/csr_engine.hpp"
+#include "model/simulation_options.hpp"
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    simulation_options options(argc, argv);
+    options.check_branches();
+
+    simulation_outputs outputs(options);
+
+    csr_engine engine(options.scenario_path, max(options.threads, 1u), outputs.state_log(), outputs.messages_log(), options.compact);
+    outputs.attach(engine, options);
+
+    if (options.branches_path.empty())
+    {
+        float stop_time = engine.run_until(options.sim_time);
+        if (options.convergence.reason() != convergence_monitor::NONE)
+            cout << "\r\033[33mStopped after day " << stop_time - 1 << ", " << convergence_monitor::name(options.convergence.reason()) << "\033[0m" << endl;
+    }
+    else
+    {
+        // The simulation runs until the fork day, then each branch carries it on with its own text logs
+        branch_spec spec = branch_spec::read(options.branches_path);
+        engine.run_until(min(spec.fork_day, options.sim_time));
+
+        for (simulation_branch const& branch : spec.branches)
+        {
+            ofstream branch_messages("../logs/pandemic_messages_" + branch.name + ".txt");
+            ofstream branch_state("../logs/pandemic_state_" + branch.name + ".txt");
+            if (!branch_messages.is_open() || !branch_state.is_open())
+                throw runtime_error{"Unable to open the logs of the branch " + branch.name};
+
+            unique_ptr<csr_engine> fork = engine.fork(branch_state, branch_messages);
+            branch.apply(*fork);
+            if (!options.no_progress)
+                fork->turn_progress_on();
+
+            fork->run_until(options.sim_time);
+        }
+    }
+
+    // The spaces at the the end are necessary to clear the terminal
+    // line that's being overwritten
+    cout << "\r\033[1;32mDone.       \033[0m" << endl;
+    return 0;
+} //main()
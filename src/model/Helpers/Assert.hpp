@@ -5,16 +5,25 @@ using namespace std;
 
 namespace Assert
 {
-    void AssertLong(bool condition, string file, unsigned int line, string message="")
+    // The file is only turned into a string when the assertion fails, so asserting doesn't allocate
+    void AssertLong(bool condition, char const* file, unsigned int line, string message="")
     {
         if (!condition)
         {
-            string filename = file.substr(file.find_last_of("/\\") + 1);
+            string path     = file;
+            string filename = path.substr(path.find_last_of("/\\") + 1);
             cout << "\n\033[1;31mASSERT in " << filename << " (ln" << line 
                 << ") \033[0;31m" << message << "\033[0m" << endl;
             abort();
         }
     }
+
+    // Nor does asserting with a literal message, which is only turned into a string when the assertion fails
+    void AssertLong(bool condition, char const* file, unsigned int line, char const* message)
+    {
+        if (!condition)
+            AssertLong(condition, file, line, string{message});
+    }
 } // Assert
 
 #endif
\ No newline at end of file
@@ -0,0 +1,301 @@
+#ifndef ASYNC_LOG_STREAM_HPP
+#define ASYNC_LOG_STREAM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Lock-free queue of a fixed capacity between exactly one producer thread and one consumer thread
+*/
+template <typename V>
+class spsc_queue
+{
+    vector<V> slots; // One more slot than the capacity to tell a full queue from an empty one
+    atomic<size_t> head{0}; // Next slot to pop, only moved by the consumer
+    atomic<size_t> tail{0}; // Next slot to push, only moved by the producer
+
+    public:
+        explicit spsc_queue(size_t capacity) : slots(capacity + 1) { }
+
+        bool push(V value)
+        {
+            size_t current = tail.load(memory_order_relaxed);
+            size_t next    = (current + 1) % slots.size();
+
+            if (next == head.load(memory_order_acquire))
+                return false;
+
+            slots[current] = move(value);
+            tail.store(next, memory_order_release);
+            return true;
+        }
+
+        bool pop(V& value)
+        {
+            size_t current = head.load(memory_order_relaxed);
+            if (current == tail.load(memory_order_acquire))
+                return false;
+
+            value = move(slots[current]);
+            head.store((current + 1) % slots.size(), memory_order_release);
+            return true;
+        }
+
+        bool empty() const { return head.load(memory_order_acquire) == tail.load(memory_order_acquire); }
+}; //class spsc_queue{}
+
+/**
+ * Stream buffer writing to another stream from a background thread.
+ *
+ * The text is formatted into one of a fixed number of buffers; once a buffer is full it is handed
+ * to the writer thread through a lock-free queue and the next free buffer is used. The writer thread
+ * hands the buffers back once written, so the memory used is bounded: when the disk falls behind and
+ * every buffer is waiting to be written, the simulation waits for one to be freed.
+ *
+ * Flushing hands the current buffer off and waits until the writer thread wrote everything to the
+ * destination, which is flushed too, so it's only worth doing now and then: the Cadmium loggers, which
+ * flush after every line, write through an unflushed_stream. tellp() gives where the text written
+ * so far ends in the destination.
+*/
+class async_log_buffer : public streambuf
+{
+    struct log_buffer
+    {
+        vector<char> bytes;
+        size_t used = 0;
+    };
+
+    ostream& destination;
+    vector<unique_ptr<log_buffer>> buffers;
+    spsc_queue<log_buffer*> filled;       // Simulation thread -> writer thread
+    spsc_queue<log_buffer*> free_buffers; // Writer thread -> simulation thread
+    log_buffer* current = nullptr;
+    streamoff handed_off = 0; // Position in the destination of the start of the current buffer
+    size_t buffers_handed_off = 0;     // Counted by the simulation thread
+    atomic<size_t> buffers_written{0}; // Counted by the writer thread, flushing waits for it to catch up
+
+    // Only used to sleep when there is nothing to do, the buffers themselves go through the queues
+    mutex lock;
+    condition_variable buffer_filled;
+    condition_variable buffer_freed;
+    atomic<bool> stopping{false};
+
+    thread writer;
+
+    public:
+        /**
+         * @param destination Stream to write to
+         * @param buffer_size Size in bytes of each buffer
+         * @param num_buffers Number of buffers, at least 2 so one can be filled while the other is written
+        */
+        explicit async_log_buffer(ostream& destination, size_t buffer_size=1 << 20, size_t num_buffers=4) :
+            destination{destination}, filled{max<size_t>(num_buffers, 2)}, free_buffers{max<size_t>(num_buffers, 2)},
+            handed_off{max<streamoff>(destination.tellp(), 0)}
+        {
+            for (size_t i = 0; i < max<size_t>(num_buffers, 2); ++i)
+            {
+                buffers.emplace_back(new log_buffer{vector<char>(max<size_t>(buffer_size, 1))});
+                free_buffers.push(buffers.back().get());
+            }
+
+            next_buffer();
+            writer = thread(&async_log_buffer::write_buffers, this);
+        }
+
+        ~async_log_buffer()
+        {
+            hand_off();
+
+            {
+                lock_guard<mutex> guard(lock);
+                stopping = true;
+            }
+            buffer_filled.notify_one();
+
+            writer.join();
+            destination.flush();
+        }
+
+        async_log_buffer(async_log_buffer const&)            = delete;
+        async_log_buffer& operator=(async_log_buffer const&) = delete;
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            hand_off();
+            next_buffer();
+
+            if (!traits_type::eq_int_type(c, traits_type::eof()))
+            {
+                *pptr() = traits_type::to_char_type(c);
+                pbump(1);
+            }
+
+            return traits_type::not_eof(c);
+        }
+
+        streamsize xsputn(char const* text, streamsize count) override
+        {
+            streamsize written = 0;
+            while (written < count)
+            {
+                if (pptr() == epptr())
+                    overflow(traits_type::eof());
+
+                streamsize chunk = min<streamsize>(count - written, epptr() - pptr());
+                traits_type::copy(pptr(), text + written, chunk);
+                pbump(chunk);
+                written += chunk;
+            }
+
+            return written;
+        }
+
+        int sync() override
+        {
+            hand_off();
+
+            {
+                unique_lock<mutex> guard(lock);
+                buffer_freed.wait(guard, [this]{ return buffers_written.load() == buffers_handed_off; });
+            }
+
+            // The writer thread is waiting for a buffer, it doesn't touch the destination
+            destination.flush();
+            next_buffer();
+
+            return destination.fail() ? -1 : 0;
+        }
+
+        pos_type seekoff(off_type offset, ios_base::seekdir direction, ios_base::openmode which) override
+        {
+            if (offset != 0 || direction != ios_base::cur || !(which & ios_base::out))
+                return pos_type(off_type(-1));
+
+            return handed_off + (pptr() - pbase());
+        }
+
+    private:
+        // Sends the current buffer to the writer thread
+        void hand_off()
+        {
+            if (current == nullptr)
+                return;
+
+            current->used = pptr() - pbase();
+            handed_off   += current->used;
+            filled.push(current); // Can't fail, there are as many slots as buffers
+            ++buffers_handed_off;
+            current = nullptr;
+            setp(nullptr, nullptr);
+
+            {
+                lock_guard<mutex> guard(lock);
+            }
+            buffer_filled.notify_one();
+        }
+
+        // Takes a free buffer, waiting for the writer thread to free one if they're all in use
+        void next_buffer()
+        {
+            if (!free_buffers.pop(current))
+            {
+                unique_lock<mutex> guard(lock);
+                buffer_freed.wait(guard, [this]{ return free_buffers.pop(current); });
+            }
+
+            setp(current->bytes.data(), current->bytes.data() + current->bytes.size());
+        }
+
+        void write_buffers()
+        {
+            log_buffer* buffer = nullptr;
+
+            while (true)
+            {
+                if (!filled.pop(buffer))
+                {
+                    unique_lock<mutex> guard(lock);
+                    buffer_filled.wait(guard, [&]{ return filled.pop(buffer) || stopping; });
+
+                    // The last buffer is handed off before stopping so nothing is left to write
+                    if (buffer == nullptr)
+                        return;
+                }
+
+                destination.write(buffer->bytes.data(), buffer->used);
+                buffer->used = 0;
+                free_buffers.push(buffer);
+                buffer = nullptr;
+                ++buffers_written;
+
+                {
+                    lock_guard<mutex> guard(lock);
+                }
+                buffer_freed.notify_one();
+            }
+        }
+}; //class async_log_buffer{}
+
+/**
+ * Output stream whose text is written to another stream by a background thread, see async_log_buffer
+*/
+class async_log_stream : public ostream
+{
+    async_log_buffer buffer;
+
+    public:
+        explicit async_log_stream(ostream& destination) : ostream(nullptr), buffer(destination)
+        {
+            rdbuf(&buffer);
+            copyfmt(destination);
+        }
+}; //class async_log_stream{}
+
+/**
+ * Stream writing to another stream without passing its flushes on, for the Cadmium loggers which flush
+ * after every line: an async_log_stream would wait for its writer thread every time otherwise
+*/
+class unflushed_stream : public ostream
+{
+    class unflushed_buffer : public streambuf
+    {
+        streambuf* destination;
+
+        public:
+            explicit unflushed_buffer(streambuf* destination) : destination{destination} { }
+
+        protected:
+            int_type overflow(int_type c) override
+            {
+                if (traits_type::eq_int_type(c, traits_type::eof()))
+                    return traits_type::not_eof(c);
+
+                return destination->sputc(traits_type::to_char_type(c));
+            }
+
+            streamsize xsputn(char const* text, streamsize count) override { return destination->sputn(text, count); }
+
+            int sync() override { return 0; }
+    }; //class unflushed_buffer{}
+
+    unflushed_buffer buffer;
+
+    public:
+        explicit unflushed_stream(ostream& destination) : ostream(nullptr), buffer(destination.rdbuf())
+        {
+            rdbuf(&buffer);
+            copyfmt(destination);
+        }
+}; //class unflushed_stream{}
+
+#endif // ASYNC_LOG_STREAM_HPP
@@ -0,0 +1,250 @@
+#ifndef BINARY_IO_HPP
+#define BINARY_IO_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace std;
+
+/**
+ * Read-only view of a whole file. The file is memory mapped where mmap is available
+ * so only the pages that are read get loaded, otherwise it is read into memory.
+*/
+class mapped_file
+{
+    char const* bytes = nullptr;
+    size_t length     = 0;
+    vector<char> buffer; // Only used without mmap
+
+    public:
+        explicit mapped_file(string const& file_path)
+        {
+#ifndef _WIN32
+            int fd = open(file_path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw runtime_error{"Unable to open the file: " + file_path};
+
+            struct stat info;
+            if (fstat(fd, &info) == 0 && info.st_size > 0)
+            {
+                length = info.st_size;
+
+                void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    close(fd);
+                    throw runtime_error{"Unable to map the file: " + file_path};
+                }
+
+                bytes = static_cast<char const*>(mapping);
+            }
+            close(fd);
+#else
+            ifstream file(file_path, ios::binary);
+            if (!file.is_open())
+                throw runtime_error{"Unable to open the file: " + file_path};
+
+            buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+            bytes  = buffer.data();
+            length = buffer.size();
+#endif
+        }
+
+        ~mapped_file()
+        {
+#ifndef _WIN32
+            if (bytes != nullptr)
+                munmap(const_cast<char*>(bytes), length);
+#endif
+        }
+
+        mapped_file(mapped_file const&)            = delete;
+        mapped_file& operator=(mapped_file const&) = delete;
+
+        char const* data() const { return bytes; }
+        size_t size() const      { return length; }
+}; //class mapped_file{}
+
+/**
+ * @brief Cuts a file down to its first bytes
+ *
+ * @param file_path Path of the file
+ * @param size Number of bytes to keep, the file must be at least that long
+*/
+inline void truncate_file(string const& file_path, uint64_t size)
+{
+    ifstream existing(file_path, ios::binary | ios::ate);
+    if (!existing.is_open())
+        throw runtime_error{"Unable to open the file: " + file_path};
+
+    uint64_t length = existing.tellg();
+    if (length < size)
+        throw runtime_error{"Unable to truncate the file: " + file_path + ", it is shorter than " + to_string(size) + " bytes"};
+    if (length == size)
+        return;
+
+#ifndef _WIN32
+    existing.close();
+    if (truncate(file_path.c_str(), size) != 0)
+        throw runtime_error{"Unable to truncate the file: " + file_path};
+#else
+    // Without truncate() the bytes that are kept are copied next to the file then renamed over it
+    string partial_path = file_path + ".partial";
+    {
+        ofstream kept(partial_path, ios::binary);
+        vector<char> chunk(1 << 20);
+
+        existing.seekg(0);
+        for (uint64_t left = size; left > 0 && kept; )
+        {
+            size_t count = min<uint64_t>(left, chunk.size());
+            existing.read(chunk.data(), count);
+            kept.write(chunk.data(), count);
+            left -= count;
+        }
+
+        if (!existing || !kept)
+            throw runtime_error{"Unable to truncate the file: " + file_path};
+    }
+
+    existing.close();
+    remove(file_path.c_str());
+    if (rename(partial_path.c_str(), file_path.c_str()) != 0)
+        throw runtime_error{"Unable to truncate the file: " + file_path};
+#endif
+}
+
+/**
+ * @brief Opens a file to write, from scratch or after the bytes written by a previous run
+ *
+ * @param file Stream to open, check is_open() afterwards
+ * @param file_path Path of the file
+ * @param kept Number of bytes of the previous run to keep, the file is started over when negative
+ * @param mode Mode to open the file in
+*/
+inline void open_continued(ofstream& file, string const& file_path, streamoff kept, ios::openmode mode=ios::out)
+{
+    if (kept < 0)
+    {
+        file.open(file_path, mode);
+        return;
+    }
+
+    truncate_file(file_path, kept);
+    file.open(file_path, mode | ios::in);
+    if (file.is_open())
+        file.seekp(0, ios::end);
+}
+
+/**
+ * Writes plain values in the native byte order, arrays being prefixed by their length
+*/
+class binary_writer
+{
+    ostream& out;
+
+    public:
+        explicit binary_writer(ostream& out) : out{out} { }
+
+        template <typename V>
+        void write(V const& value)
+        {
+            static_assert(is_trivially_copyable<V>::value, "Only plain values can be written as is");
+            out.write(reinterpret_cast<char const*>(&value), sizeof(V));
+        }
+
+        template <typename V>
+        void write_array(V const* values, size_t count)
+        {
+            static_assert(is_trivially_copyable<V>::value, "Only plain values can be written as is");
+            out.write(reinterpret_cast<char const*>(values), count * sizeof(V));
+        }
+
+        template <typename V>
+        void write_vector(vector<V> const& values)
+        {
+            write<uint32_t>(values.size());
+            write_array(values.data(), values.size());
+        }
+
+        void write_string(string const& text)
+        {
+            write<uint32_t>(text.size());
+            out.write(text.data(), text.size());
+        }
+}; //class binary_writer{}
+
+/**
+ * Reads back what a binary_writer wrote, making sure it never reads past the end of the bytes
+*/
+class binary_reader
+{
+    char const* cursor;
+    char const* end;
+    string source; // For the error messages
+
+    public:
+        binary_reader(char const* bytes, size_t length, string source) :
+            cursor{bytes}, end{bytes + length}, source{move(source)} { }
+
+        template <typename V>
+        V read()
+        {
+            static_assert(is_trivially_copyable<V>::value, "Only plain values can be read as is");
+            V value;
+            memcpy(&value, take(sizeof(V)), sizeof(V));
+            return value;
+        }
+
+        template <typename V>
+        void read_array(V* values, size_t count)
+        {
+            static_assert(is_trivially_copyable<V>::value, "Only plain values can be read as is");
+            if (count > 0)
+                memcpy(values, take(count * sizeof(V)), count * sizeof(V));
+        }
+
+        template <typename V>
+        vector<V> read_vector()
+        {
+            vector<V> values(read<uint32_t>());
+            read_array(values.data(), values.size());
+            return values;
+        }
+
+        string read_string()
+        {
+            uint32_t length = read<uint32_t>();
+            return string(take(length), length);
+        }
+
+        size_t remaining() const { return end - cursor; }
+
+    private:
+        char const* take(size_t count)
+        {
+            if (count > remaining())
+                throw runtime_error{"Unexpected end of " + source};
+
+            char const* bytes = cursor;
+            cursor += count;
+            return bytes;
+        }
+}; //class binary_reader{}
+
+#endif // BINARY_IO_HPP
@@ -0,0 +1,103 @@
+#ifndef CHARS_WRITER_HPP
+#define CHARS_WRITER_HPP
+
+#include <charconv>
+#include <cstdio>
+#include <locale>
+#include <ostream>
+#include <system_error>
+
+using namespace std;
+
+/**
+ * Formats text into a fixed buffer on the stack and hands it to a stream in large blocks,
+ * without going through the stream's locale or allocating anything.
+ * Numbers come out the same as a stream with its default flags and the classic locale writes them.
+*/
+class chars_writer
+{
+    ostream& os;
+    char buffer[512];
+    size_t used = 0;
+
+    static constexpr size_t max_number_size = 64;
+
+    public:
+        explicit chars_writer(ostream& os) : os{os} { }
+
+        ~chars_writer() { flush(); }
+
+        chars_writer(chars_writer const&)            = delete;
+        chars_writer& operator=(chars_writer const&) = delete;
+
+        void put(char c)
+        {
+            if (used == sizeof(buffer))
+                flush();
+
+            buffer[used++] = c;
+        }
+
+        void put(unsigned long value)
+        {
+            if (sizeof(buffer) - used < max_number_size)
+                flush();
+
+            used = to_chars(buffer + used, buffer + sizeof(buffer), value).ptr - buffer;
+        }
+
+        /**
+         * @brief Writes a number like printf's %g does, which is what streams do with their default flags
+         *
+         * @param value Number to write
+         * @param precision Number of significant digits, the precision of the stream
+        */
+        void put(double value, int precision)
+        {
+            if (sizeof(buffer) - used < max_number_size)
+                flush();
+
+            char* first = buffer + used;
+            char* last  = buffer + sizeof(buffer);
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+            to_chars_result result = to_chars(first, last, value, chars_format::general, precision);
+            if (result.ec == errc{})
+            {
+                used = result.ptr - buffer;
+                return;
+            }
+#else
+            int length = snprintf(first, last - first, "%.*g", precision, value);
+            if (length >= 0 && length < last - first)
+            {
+                used += length;
+                return;
+            }
+#endif
+
+            // Only a huge precision doesn't fit in the buffer
+            flush();
+            os << value;
+        }
+
+        void flush()
+        {
+            os.write(buffer, used);
+            used = 0;
+        }
+
+        /**
+         * @brief Tells if the numbers of a stream are written the way put() writes them
+         *
+         * @param os Stream to check
+         * @return bool
+        */
+        static bool formats_like(ostream const& os)
+        {
+            return (os.flags() & (ios::floatfield | ios::showpoint | ios::showpos | ios::uppercase)) == 0
+                    && os.width() == 0 && os.getloc() == locale::classic();
+        }
+}; //class chars_writer{}
+
+#endif // CHARS_WRITER_HPP
@@ -0,0 +1,198 @@
+#ifndef WORK_STEALING_POOL_HPP
+#define WORK_STEALING_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Fixed pool of threads running parallel loops. Each loop is cut into small chunks that are
+ * dealt out evenly to every thread; a thread that runs out of chunks steals from the others,
+ * which balances loops where some iterations cost a lot more than others.
+ * The thread calling parallel_for() also works on the loop.
+ *
+ * Running a loop allocates nothing so the runners don't allocate on the days they simulate:
+ * the chunks of each thread are a range of chunk numbers and the body isn't copied.
+*/
+class work_stealing_pool
+{
+    struct worker_queue
+    {
+        mutex lock;
+        unsigned int first = 0, last = 0; // [first, last) chunks left
+    };
+
+    vector<unique_ptr<worker_queue>> queues; // One per thread, the caller's being the first
+    vector<thread> threads;
+
+    mutex lock;
+    condition_variable start_loop;
+    condition_variable end_loop;
+
+    void const* body = nullptr;
+    void (*run_body)(void const* body, unsigned int i) = nullptr;
+    unsigned int count = 0, grain = 1;
+    atomic<unsigned int> chunks_left{0};
+    unsigned int generation = 0; // Incremented on every loop so the threads know a new one started
+    unsigned int workers_done = 0;
+    bool stopping = false;
+
+    public:
+        explicit work_stealing_pool(unsigned int num_threads)
+        {
+            num_threads = max(num_threads, 1u);
+
+            for (unsigned int i = 0; i < num_threads; ++i)
+                queues.emplace_back(new worker_queue{});
+
+            for (unsigned int i = 1; i < num_threads; ++i)
+                threads.emplace_back(&work_stealing_pool::worker, this, i);
+        }
+
+        ~work_stealing_pool()
+        {
+            {
+                lock_guard<mutex> guard(lock);
+                stopping = true;
+            }
+            start_loop.notify_all();
+
+            for (thread& t : threads)
+                t.join();
+        }
+
+        work_stealing_pool(work_stealing_pool const&)            = delete;
+        work_stealing_pool& operator=(work_stealing_pool const&) = delete;
+
+        unsigned int size() const { return queues.size(); }
+
+        /**
+         * @brief Runs body(i) for every i in [0, count) and returns once they are all done
+         *
+         * @param count Number of iterations
+         * @param body Iteration to run, must be safe to call concurrently for different i
+         * @param grain Number of iterations in a chunk
+        */
+        template <typename BODY>
+        void parallel_for(unsigned int count, BODY const& body, unsigned int grain=8)
+        {
+            if (count == 0)
+                return;
+
+            grain = max(grain, 1u);
+
+            // Deal contiguous runs of chunks to each queue so a thread's own chunks stay close in memory
+            unsigned int num_chunks = (count + grain - 1) / grain;
+            for (unsigned int q = 0; q < size(); ++q)
+            {
+                worker_queue& queue = *queues.at(q);
+                lock_guard<mutex> guard(queue.lock);
+                queue.first = ((unsigned long)q * num_chunks + size() - 1) / size();
+                queue.last  = ((unsigned long)(q + 1) * num_chunks + size() - 1) / size();
+            }
+
+            {
+                lock_guard<mutex> guard(lock);
+                this->body     = &body;
+                this->run_body = [](void const* body, unsigned int i) { (*static_cast<BODY const*>(body))(i); };
+                this->count    = count;
+                this->grain    = grain;
+                chunks_left    = num_chunks;
+                workers_done = 0;
+                ++generation;
+            }
+            start_loop.notify_all();
+
+            run_chunks(0);
+
+            // Wait for the other threads to let go of the body before it goes out of scope
+            unique_lock<mutex> guard(lock);
+            end_loop.wait(guard, [this]{ return workers_done == threads.size(); });
+            this->body = nullptr;
+        }
+
+    private:
+        void worker(unsigned int id)
+        {
+            unsigned int seen = 0;
+
+            while (true)
+            {
+                {
+                    unique_lock<mutex> guard(lock);
+                    start_loop.wait(guard, [&]{ return stopping || generation != seen; });
+                    if (stopping)
+                        return;
+
+                    seen = generation;
+                }
+
+                run_chunks(id);
+
+                {
+                    lock_guard<mutex> guard(lock);
+                    ++workers_done;
+                }
+                end_loop.notify_one();
+            }
+        }
+
+        void run_chunks(unsigned int id)
+        {
+            unsigned int work;
+
+            while (chunks_left > 0)
+            {
+                if (!pop(id, work) && !steal(id, work))
+                {
+                    this_thread::yield();
+                    continue;
+                }
+
+                unsigned int end = min(count, (work + 1) * grain);
+                for (unsigned int i = work * grain; i < end; ++i)
+                    run_body(body, i);
+
+                --chunks_left;
+            }
+        }
+
+        // The owner takes from the back of its queue...
+        bool pop(unsigned int id, unsigned int& work)
+        {
+            worker_queue& queue = *queues.at(id);
+            lock_guard<mutex> guard(queue.lock);
+
+            if (queue.first == queue.last)
+                return false;
+
+            work = --queue.last;
+            return true;
+        }
+
+        // ...while thieves take from the front, the chunks furthest from what the owner is working on
+        bool steal(unsigned int id, unsigned int& work)
+        {
+            for (unsigned int offset = 1; offset < size(); ++offset)
+            {
+                worker_queue& queue = *queues.at((id + offset) % size());
+                lock_guard<mutex> guard(queue.lock);
+
+                if (queue.first == queue.last)
+                    continue;
+
+                work = queue.first++;
+                return true;
+            }
+
+            return false;
+        }
+}; //class work_stealing_pool{}
+
+#endif // WORK_STEALING_POOL_HPP
@@ -0,0 +1,236 @@
+#ifndef PANDEMIC_HOYA_2002_AGGREGATE_LOG_HPP
+#define PANDEMIC_HOYA_2002_AGGREGATE_LOG_HPP
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "weighted_rows.hpp"
+#include "cells/sevirds.hpp"
+#include "Helpers/binary_io.hpp"
+#include "Helpers/chars_writer.hpp"
+#include "Helpers/Assert.hpp"
+
+using namespace std;
+
+/**
+ * Population weighted time series of the whole scenario and of groups of cells, such as the
+ * CSDcodes of a regions file, written as csv while the simulation runs.
+ *
+ * Every row gives, at the end of a day, the population of the cells and the proportion of it in each
+ * field of visit_fields(): S, E, VD1, VD2, I, R, New_E, New_I, New_R, D then the boosters. These are the
+ * columns of the aggregate_timeseries.csv written by Scripts/Graph_Generator/graph_aggregates.py.
+ *
+ * The population weighted fields of each cell are kept by weighted_rows, only computed again when the cell changes state.
+*/
+class aggregate_log
+{
+    string global_path;
+    string groups_path;
+    ofstream global_file;
+    ofstream groups_file;
+
+    unordered_map<string, string> group_codes; // Group of each cell
+    string group_column;
+    vector<string> groups;                     // Codes of the groups, sorted
+    vector<unsigned int> cell_groups;          // Position in groups of the group of each cell, groups.size() if it has none
+
+    unsigned int num_fields = 0;
+    weighted_rows weighted;
+    vector<double> totals; // Sums of the rows of weighted for the scenario then for each group
+
+    bool finished = false;
+
+    public:
+        /**
+         * @param global_path Path of the time series of the whole scenario, not written if empty
+         * @param kept Size of the time series of a previous run to carry on from, it is started over when negative
+        */
+        explicit aggregate_log(string global_path, streamoff kept=-1) : global_path{move(global_path)}
+        {
+            open(global_file, this->global_path, kept);
+        }
+
+        ~aggregate_log() { finish(); }
+
+        aggregate_log(aggregate_log const&)            = delete;
+        aggregate_log& operator=(aggregate_log const&) = delete;
+
+        /**
+         * @brief Also writes the time series of each group of cells
+         *
+         * @param path Path of the time series of the groups
+         * @param codes Group of each cell, see read_region_codes(). The cells without one are only part of the whole scenario
+         * @param column Name of the codes, the header of their column
+         * @param kept Size of the time series of a previous run to carry on from, it is started over when negative
+        */
+        void group_by(string path, unordered_map<string, string> codes, string column="CSDcode", streamoff kept=-1)
+        {
+            groups_path  = move(path);
+            group_codes  = move(codes);
+            group_column = move(column);
+            open(groups_file, groups_path, kept);
+        }
+
+        /**
+         * @brief Sets the cells up from their initial states
+         *
+         * @param ids IDs of the cells, in the order of their indices
+         * @param state Gives the state of the cell at an index
+        */
+        template <typename STATE>
+        void start(vector<string> const& ids, STATE&& state)
+        {
+            weighted.start(ids.size(), state);
+            num_fields = weighted.fields();
+
+            for (auto const& code : group_codes)
+                groups.push_back(code.second);
+            sort(groups.begin(), groups.end());
+            groups.erase(unique(groups.begin(), groups.end()), groups.end());
+
+            for (string const& id : ids)
+            {
+                auto code = group_codes.find(id);
+                cell_groups.push_back(code == group_codes.end() ? groups.size()
+                                        : lower_bound(groups.begin(), groups.end(), code->second) - groups.begin());
+            }
+
+            totals.assign((groups.size() + 1) * num_fields, 0);
+
+            write_header(global_file, "sim_time");
+            write_header(groups_file, "sim_time," + group_column);
+        }
+
+        /**
+         * @brief Writes the rows of a day
+         *
+         * @param time Time of the day
+         * @param changed Has each cell changed state on the day?
+         * @param state Gives the state of the cell at an index
+        */
+        template <typename TIME, typename STATE>
+        void day(TIME time, vector<char> const& changed, STATE&& state)
+        {
+            fill(totals.begin(), totals.end(), 0);
+            weighted.update(changed, state);
+
+            for (unsigned int i = 0; i < cell_groups.size(); ++i)
+            {
+                double const* cell = weighted.row(i);
+                double* global     = &totals[0];
+                double* group      = cell_groups[i] < groups.size() ? &totals[(cell_groups[i] + 1) * num_fields] : nullptr;
+
+                for (unsigned int f = 0; f < num_fields; ++f)
+                {
+                    global[f] += cell[f];
+                    if (group)
+                        group[f] += cell[f];
+                }
+            }
+
+            if (global_file.is_open())
+            {
+                chars_writer out(global_file);
+                write_time(out, time);
+                write_row(out, global_file, 0);
+            }
+
+            if (groups_file.is_open())
+            {
+                chars_writer out(groups_file);
+                for (unsigned int g = 0; g < groups.size(); ++g)
+                {
+                    write_time(out, time);
+                    out.put(',');
+                    for (char c : groups[g])
+                        out.put(c);
+                    write_row(out, groups_file, g + 1);
+                }
+            }
+        }
+
+        /**
+         * @brief Writes the rows of the days so far to the files
+        */
+        void flush()
+        {
+            if (global_file.is_open())
+                global_file.flush();
+            if (groups_file.is_open())
+                groups_file.flush();
+        }
+
+        /**
+         * @brief Sizes of the time series of the whole scenario and of the groups so far, -1 for those that aren't written
+        */
+        streamoff global_size() { return global_file.is_open() ? global_file.tellp() : streampos(-1); }
+        streamoff groups_size() { return groups_file.is_open() ? groups_file.tellp() : streampos(-1); }
+
+        /**
+         * @brief Writes what's left of the time series
+        */
+        void finish()
+        {
+            if (finished)
+                return;
+
+            finished = true;
+            close(global_file, global_path);
+            close(groups_file, groups_path);
+        }
+
+    private:
+        static void open(ofstream& file, string const& path, streamoff kept)
+        {
+            if (path.empty())
+                return;
+
+            open_continued(file, path, kept);
+            if (!file.is_open())
+                throw runtime_error{"Unable to open the file: " + path};
+        }
+
+        static void close(ofstream& file, string const& path)
+        {
+            if (!file.is_open())
+                return;
+
+            file.close();
+            AssertLong(!file.fail(), __FILE__, __LINE__, "Unable to write the time series " + path);
+        }
+
+        // Time series carried on from a previous run already have theirs
+        void write_header(ofstream& file, string const& first_columns)
+        {
+            if (!file.is_open() || file.tellp() > 0)
+                return;
+
+            file << first_columns << ",population,S,E,VD1,VD2,I,R,New_E,New_I,New_R,D";
+            for (unsigned int booster = 1; booster + 11 <= num_fields; ++booster)
+                file << ",booster" << booster;
+            file << "\n";
+        }
+
+        template <typename TIME>
+        static void write_time(chars_writer& out, TIME time)
+        {
+            out.put(static_cast<double>(time), 17);
+        }
+
+        // Writes the population of a row of totals then the proportion of it in each field
+        void write_row(chars_writer& out, ostream const& file, unsigned int row)
+        {
+            double const* total = &totals[row * num_fields];
+
+            for (unsigned int f = 0; f < num_fields; ++f)
+            {
+                out.put(',');
+                out.put(f == 0 || total[0] == 0 ? total[f] : total[f] / total[0], file.precision());
+            }
+            out.put('\n');
+        }
+}; //class aggregate_log{}
+
+#endif //PANDEMIC_HOYA_2002_AGGREGATE_LOG_HPP
@@ -0,0 +1,300 @@
+#ifndef PANDEMIC_HOYA_2002_BINARY_STATE_LOG_HPP
+#define PANDEMIC_HOYA_2002_BINARY_STATE_LOG_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+#include "Helpers/binary_io.hpp"
+#include "Helpers/Assert.hpp"
+
+using namespace std;
+
+/**
+ * Binary alternative to the text state log. It holds the same values, those of visit_fields()
+ * or the fields selected by a log_filter, as fixed-width records that can be read back without parsing any text.
+ *
+ * All the values are in the byte order of the machine that ran the simulation:
+ *   header:    magic "SEVIRDSL", version, byte order mark (0x01020304), size of the values (4 or 8),
+ *              number of fields, number of cells, number of days, offset of the day table,
+ *              then the names of the fields and the IDs of the cells
+ *   days:      the records of each day stored column by column: day index, cell index, then one column per field
+ *   day table: for each day its time, the offset of its records and their number
+ *
+ * The first day holds the initial states of the cells, logged before the simulation starts, and has a NaN time.
+ * Every following day matches one time of the text log.
+ *
+ * The records of a day are written once it's over, so a resumed simulation can carry the log on from the size
+ * and the day table it had when the checkpoint was written.
+*/
+class binary_state_log
+{
+    public:
+        struct day_entry
+        {
+            double time;
+            uint64_t offset;
+            uint32_t records;
+        };
+
+    private:
+    static constexpr char magic[8]     = {'S', 'E', 'V', 'I', 'R', 'D', 'S', 'L'};
+    static constexpr uint32_t version    = 1;
+    static constexpr uint32_t byte_order = 0x01020304;
+
+    // Position in the header of the values only known once the log is finished
+    static constexpr streamoff num_days_position = sizeof(magic) + 5 * sizeof(uint32_t);
+
+    string path;
+    ofstream file;
+    binary_writer out{file};
+
+    bool single_precision;
+    vector<string> field_names;
+    vector<string> cell_ids;
+
+    bool started  = false;
+    bool finished = false;
+    bool day_open = false; // Are the records of the last day of days still to be written?
+    vector<day_entry> days;
+
+    // Number of fields and of cells of a log carried on from a previous run, read from its header
+    uint32_t resumed_fields = 0;
+    uint32_t resumed_cells  = 0;
+
+    // Records of the day being logged, one row of field values after the other
+    vector<uint32_t> day_cells;
+    vector<double> day_values;
+
+    // One field of every record of the day, in the size it's written in
+    vector<float> float_column;
+    vector<double> double_column;
+
+    public:
+        /**
+         * @param path Path of the log to write
+         * @param single_precision Are the values written as floats rather than doubles?
+        */
+        explicit binary_state_log(string path, bool single_precision=false) :
+            path{move(path)}, file{this->path, ios::binary}, single_precision{single_precision}
+        {
+            if (!file.is_open())
+                throw runtime_error{"Unable to open the file: " + this->path};
+        }
+
+        /**
+         * @brief Carries on the log of a previous run from where it was when a checkpoint was written,
+         * what that run logged afterwards is dropped
+         *
+         * @param path Path of the log written by the previous run
+         * @param single_precision Are the values written as floats rather than doubles? As for the previous run
+         * @param logged_days Day table of the log when the checkpoint was written
+         * @param kept Size of the log when the checkpoint was written
+        */
+        binary_state_log(string path, bool single_precision, vector<day_entry> logged_days, streamoff kept) :
+            path{move(path)}, single_precision{single_precision}, days{move(logged_days)}
+        {
+            read_header();
+            open_continued(file, this->path, kept, ios::out | ios::binary);
+            if (!file.is_open())
+                throw runtime_error{"Unable to open the file: " + this->path};
+        }
+
+        ~binary_state_log() { finish(); }
+
+        binary_state_log(binary_state_log const&)            = delete;
+        binary_state_log& operator=(binary_state_log const&) = delete;
+
+        /**
+         * @brief Starts the log, the states that follow are the initial ones unless the log is carried on
+         *
+         * @param ids IDs of the cells, in the order of the cell indices given to state()
+         * @param names Names of the fields of the states
+        */
+        void start(vector<string> ids, vector<string> names)
+        {
+            cell_ids    = move(ids);
+            field_names = move(names);
+            started  = true;
+
+            if (!days.empty())
+            {
+                AssertLong(resumed_fields == field_names.size() && resumed_cells == cell_ids.size(), __FILE__, __LINE__,
+                            "The binary state log " + path + " doesn't log the cells and fields of the simulation resuming it");
+                return;
+            }
+
+            days.push_back({numeric_limits<double>::quiet_NaN(), 0, 0});
+            day_open = true;
+        }
+
+        /**
+         * @brief Starts a new day, the states that follow are the ones the cells have at its end
+         *
+         * @param time Time of the day
+        */
+        void day(double time)
+        {
+            end_day();
+            days.push_back({time, 0, 0});
+            day_open = true;
+        }
+
+        /**
+         * @brief Writes the records of the current day, no more states can be logged for it
+        */
+        void end_day()
+        {
+            if (!day_open)
+                return;
+
+            write_day();
+            day_open = false;
+        }
+
+        /**
+         * @brief Logs the state of a cell on the current day
+         *
+         * @param cell Index of the cell
+         * @param values Value of each field of the state of the cell
+        */
+        void state(unsigned int cell, vector<double> const& values)
+        {
+            AssertLong(values.size() == field_names.size(), __FILE__, __LINE__,
+                        "The state of " + cell_ids.at(cell) + " has " + to_string(values.size()) + " fields but "
+                        + to_string(field_names.size()) + " are named for the binary state log");
+
+            day_values.insert(day_values.end(), values.begin(), values.end());
+            day_cells.push_back(cell);
+        }
+
+        /**
+         * @brief Writes what's left of the log along with its day table
+        */
+        void finish()
+        {
+            if (!started || finished)
+                return;
+
+            end_day();
+            finished = true;
+
+            uint64_t table_offset = file.tellp();
+            for (day_entry const& entry : days)
+            {
+                out.write(entry.time);
+                out.write(entry.offset);
+                out.write(entry.records);
+            }
+
+            file.seekp(num_days_position);
+            out.write<uint32_t>(days.size());
+            out.write(table_offset);
+            file.close();
+
+            AssertLong(!file.fail(), __FILE__, __LINE__, "Unable to write the binary state log " + path);
+        }
+
+        /**
+         * @brief Writes the records of the days that are over to the file
+        */
+        void flush() { file.flush(); }
+
+        /**
+         * @brief Size of the log so far, the records of the days that are over included
+        */
+        streamoff size() { return file.tellp(); }
+
+        /**
+         * @brief Day table of the days that are over
+        */
+        vector<day_entry> logged_days() const
+        {
+            return vector<day_entry>(days.begin(), days.end() - (day_open ? 1 : 0));
+        }
+
+    private:
+        // Checks the header of a log carried on from a previous run
+        void read_header()
+        {
+            ifstream existing(path, ios::binary);
+            if (!existing.is_open())
+                throw runtime_error{"Unable to open the file: " + path};
+
+            char file_magic[sizeof(magic)] = {};
+            uint32_t header[5] = {};
+            existing.read(file_magic, sizeof(file_magic));
+            existing.read(reinterpret_cast<char*>(header), sizeof(header));
+
+            AssertLong(existing && memcmp(file_magic, magic, sizeof(magic)) == 0, __FILE__, __LINE__, path + " is not a binary state log");
+            AssertLong(header[0] == version && header[1] == byte_order, __FILE__, __LINE__,
+                        path + " was written by another version of the simulator or on a machine of another byte order");
+            AssertLong(header[2] == (single_precision ? sizeof(float) : sizeof(double)), __FILE__, __LINE__,
+                        "--binary-log-float must be given both to the simulation writing " + path + " and to the one resuming it");
+
+            resumed_fields = header[3];
+            resumed_cells  = header[4];
+        }
+
+        void write_header()
+        {
+            file.write(magic, sizeof(magic));
+            out.write(version);
+            out.write(byte_order);
+            out.write<uint32_t>(single_precision ? sizeof(float) : sizeof(double));
+            out.write<uint32_t>(field_names.size());
+            out.write<uint32_t>(cell_ids.size());
+            out.write<uint32_t>(0); // Number of days
+            out.write<uint64_t>(0); // Offset of the day table
+
+            for (string const& name : field_names)
+                out.write_string(name);
+            for (string const& id : cell_ids)
+                out.write_string(id);
+        }
+
+        // Writes the records of the current day column by column
+        void write_day()
+        {
+            if (days.empty())
+                return;
+
+            if (days.size() == 1)
+                write_header();
+
+            day_entry& entry = days.back();
+            entry.offset     = file.tellp();
+            entry.records    = day_cells.size();
+
+            vector<uint32_t> day_column(entry.records, days.size() - 1);
+            out.write_array(day_column.data(), day_column.size());
+            out.write_array(day_cells.data(), day_cells.size());
+
+            float_column.resize(single_precision ? entry.records : 0);
+            double_column.resize(single_precision ? 0 : entry.records);
+
+            unsigned int num_fields = field_names.size();
+            for (unsigned int f = 0; f < num_fields; ++f)
+            {
+                for (unsigned int r = 0; r < entry.records; ++r)
+                {
+                    if (single_precision)
+                        float_column.at(r) = day_values[r * num_fields + f];
+                    else
+                        double_column.at(r) = day_values[r * num_fields + f];
+                }
+
+                if (single_precision)
+                    out.write_array(float_column.data(), entry.records);
+                else
+                    out.write_array(double_column.data(), entry.records);
+            }
+
+            day_cells.clear();
+            day_values.clear();
+        }
+}; //class binary_state_log{}
+
+#endif //PANDEMIC_HOYA_2002_BINARY_STATE_LOG_HPP
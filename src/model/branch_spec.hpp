@@ -0,0 +1,184 @@
+#ifndef PANDEMIC_HOYA_2002_BRANCH_SPEC_HPP
+#define PANDEMIC_HOYA_2002_BRANCH_SPEC_HPP
+
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "csr_engine.hpp"
+#include "cells/sevirds.hpp"
+#include "cells/simulation_config.hpp"
+#include "Helpers/Assert.hpp"
+
+using namespace std;
+
+/**
+ * A what-if branch of a simulation: the simulation is forked on the fork day of the branch_spec and the
+ * branch carries it on with some rates scaled and some modifiers of the states changed, in all the cells
+ * or only in those listed.
+ *
+ * Only the virulence, mobility and vaccination rates can be scaled, the others must add up to 1 from one
+ * compartment to the next. The modifiers that can be changed are disobedient, hospital_capacity and fatality_modifier.
+*/
+struct simulation_branch
+{
+    string name;
+    unordered_set<string> cells;     // IDs of the cells changed, every cell when empty
+    map<string, double> rate_scales; // Factor of each rate scaled, by its name in the scenario
+    map<string, double> modifiers;   // New value of each modifier changed
+
+    bool selects(string const& id) const { return cells.empty() || cells.count(id) != 0; }
+
+    /**
+     * @brief Applies the changes of the branch to a fork of the simulation, before running it
+     *
+     * @param engine Fork of the engine that ran the simulation until the fork day
+    */
+    void apply(csr_engine& engine) const
+    {
+        auto selected = [this](string const& id) { return selects(id); };
+
+        if (!rate_scales.empty())
+        {
+            engine.override_config([this](simulation_config& config) {
+                for (auto const& scale : rate_scales)
+                {
+                    for (vector<double>& age_group : scaled_rates(config, scale.first))
+                    {
+                        for (double& rate : age_group)
+                        {
+                            rate *= scale.second;
+                            AssertLong(scale.first.compare(0, 11, "vaccination") != 0 || rate <= 1, __FILE__, __LINE__,
+                                        "Scaling the " + scale.first + " of the branch " + name + " makes some of them greater than 1");
+                        }
+                    }
+                }
+            }, selected);
+        }
+
+        if (!modifiers.empty())
+        {
+            engine.override_states([&](string const& id, sevirds& state) {
+                if (!selected(id))
+                    return false;
+
+                for (auto const& modifier : modifiers)
+                    modifier_of(state, modifier.first) = modifier.second;
+                return true;
+            });
+        }
+    }
+
+    static bool is_scalable(string const& rates)
+    {
+        return rates == "virulence_rates" || rates == "mobility_rates" || rates == "vaccination_rates_dose1"
+                || rates == "vaccination_rates_dose2" || rates.compare(0, 25, "vaccination_rates_booster") == 0;
+    }
+
+    static bool is_modifier(string const& field)
+    {
+        return field == "disobedient" || field == "hospital_capacity" || field == "fatality_modifier";
+    }
+
+    private:
+        simulation_config::phase_rates& scaled_rates(simulation_config& config, string const& rates) const
+        {
+            if (rates == "virulence_rates")
+                return config.virulence_rates;
+            if (rates == "mobility_rates")
+                return config.mobility_rates;
+            if (rates == "vaccination_rates_dose1")
+                return config.vac1_rates;
+            if (rates == "vaccination_rates_dose2")
+                return config.vac2_rates;
+
+            // vaccination_rates_booster1, vaccination_rates_booster2...
+            unsigned long booster = strtoul(rates.c_str() + 25, nullptr, 10);
+            AssertLong(booster >= 1 && booster <= config.boosters_vaccination_rates.size(), __FILE__, __LINE__,
+                        "The branch " + name + " scales the " + rates + " of a scenario without that booster");
+            return config.boosters_vaccination_rates.at(booster - 1);
+        }
+
+        static double& modifier_of(sevirds& state, string const& field)
+        {
+            if (field == "disobedient")
+                return state.disobedient;
+            if (field == "hospital_capacity")
+                return state.hospital_capacity;
+            return state.fatality_modifier;
+        }
+}; //struct simulation_branch{}
+
+void from_json(nlohmann::json const& json, simulation_branch& branch)
+{
+    json.at("name").get_to(branch.name);
+    AssertLong(!branch.name.empty(), __FILE__, __LINE__, "Every branch needs a name");
+
+    if (json.contains("cells"))
+        branch.cells = json.at("cells").get<unordered_set<string>>();
+    if (json.contains("scale_rates"))
+        json.at("scale_rates").get_to(branch.rate_scales);
+    if (json.contains("state"))
+        json.at("state").get_to(branch.modifiers);
+
+    for (auto const& scale : branch.rate_scales)
+    {
+        AssertLong(simulation_branch::is_scalable(scale.first), __FILE__, __LINE__, "The branch " + branch.name + " can't scale the "
+                    + scale.first + ", only the virulence, mobility and vaccination rates can be scaled");
+        AssertLong(scale.second >= 0, __FILE__, __LINE__, "The branch " + branch.name + " scales the " + scale.first + " by a negative factor");
+    }
+
+    for (auto const& modifier : branch.modifiers)
+    {
+        AssertLong(simulation_branch::is_modifier(modifier.first), __FILE__, __LINE__, "The branch " + branch.name + " can't change the "
+                    + modifier.first + " of the states, only disobedient, hospital_capacity and fatality_modifier");
+    }
+}
+
+/**
+ * What-if branches of a simulation run by the CSR engine, read from a json file such as:
+ *   {"fork_day": 60, "branches": [{"name": "as_is"},
+ *                                 {"name": "half_virulence", "scale_rates": {"virulence_rates": 0.5}},
+ *                                 {"name": "disobedient", "cells": ["3501"], "state": {"disobedient": 0.4}}]}
+ *
+ * The simulation runs until the fork day, then it is forked into each branch which carries it on until
+ * the end time with its own logs. The logs of a branch start with the fork day, they follow those of the simulation.
+*/
+struct branch_spec
+{
+    float fork_day = 0;
+    vector<simulation_branch> branches;
+
+    /**
+     * @brief Reads the branches of a simulation
+     *
+     * @param spec_path Path to the json file of the branches
+     * @return branch_spec
+    */
+    static branch_spec read(string const& spec_path)
+    {
+        ifstream file(spec_path);
+        if (!file.is_open())
+            throw runtime_error{"Unable to open the file: " + spec_path};
+
+        nlohmann::json json;
+        file >> json;
+
+        branch_spec spec;
+        json.at("fork_day").get_to(spec.fork_day);
+        json.at("branches").get_to(spec.branches);
+
+        AssertLong(spec.fork_day >= 0, __FILE__, __LINE__, spec_path + " forks the simulation on a negative day");
+
+        unordered_set<string> names;
+        for (simulation_branch const& branch : spec.branches)
+            AssertLong(names.insert(branch.name).second, __FILE__, __LINE__, spec_path + " has more than one branch named " + branch.name);
+
+        return spec;
+    }
+}; //struct branch_spec{}
+
+#endif //PANDEMIC_HOYA_2002_BRANCH_SPEC_HPP
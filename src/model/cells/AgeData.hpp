@@ -15,7 +15,9 @@ static vecDouble EMPTY_VEC;
 
 /**
  * Wrapper class that holds important simulation data
- * at each age segment index during local_compute()
+ * at each age segment index during local_compute().
+ * The objects are kept from one call to the next and Reset()
+ * for each age group so computing a day doesn't allocate them
 */
 class AgeData
 {
@@ -30,12 +32,12 @@ class AgeData
             BOOSTER
         };
     private:
-        // Proportion Vectors for timestep t+1
-        // These will be at a current age segment index so only one vector of doubles
-        vecDouble& m_susceptible;
-        vecDouble& m_exposed;
-        vecDouble& m_infected;
-        vecDouble& m_recovered;
+        // Proportion phases for timestep t+1
+        // These will be at a current age segment index so only one phase of doubles
+        phase_ring m_susceptible;
+        phase_ring m_exposed;
+        phase_ring m_infected;
+        phase_ring m_recovered;
 
         // Reduces the amount of math that is done twice.
         // The values will be added in these when first done
@@ -55,25 +57,29 @@ class AgeData
         double m_totalFatalities;
         double m_totalRecoveries;
 
-        // Proportion Vectors for timestep t
-        /* Since the original vectors are being changed by the equations 
-        *   and later equations will need their values BEFORE they are 
-        *   changed let's copy them before they are change in seperate vectors.
-        *   This way we don't overcount and we don't have to do the math twice in
-        *   certain cases (ex: any equation that needs F(q) can just reference this
-        *   list instead of calculating it again).
+        // Proportions on the last day of each phase for timestep t
+        /* Advancing a phase wraps its last day around to day 0 where it gets
+        *   overwritten by the new arrivals, but some equations still need it afterwards.
+        *   Every other day of timestep t is read straight out of the phase through
+        *   the GetOrig*() getters for as long as it hasn't been overwritten.
         */
-        vecDouble m_OriginalSusceptible;
-        vecDouble m_OriginalExposed;
-        vecDouble m_OriginalInfected;
-        vecDouble m_OriginalRecovered;
-
-        // Config Vectors
-        vecDouble const& m_incubRates;
-        vecDouble const& m_recovRates;
-        vecDouble const& m_fatalRates;
-        vecDouble const& m_vacRates;
-        vecDouble const& m_immuneRates;
+        double m_origSusceptibleBack;
+        double m_origExposedBack;
+        double m_origInfectedBack;
+        double m_origRecoveredBack;
+
+        // 1 once the phase has been advanced, this is where day q of timestep t now lives
+        unsigned int m_susceptibleShift;
+        unsigned int m_exposedShift;
+        unsigned int m_infectedShift;
+        unsigned int m_recoveredShift;
+
+        // Config Vectors, pointers so Reset() can point them at another age group
+        vecDouble const* m_incubRates;
+        vecDouble const* m_recovRates;
+        vecDouble const* m_fatalRates;
+        vecDouble const* m_vacRates;
+        vecDouble const* m_immuneRates;
 
         // Phase Lengths
         unsigned int m_susceptiblePhase;
@@ -83,60 +89,91 @@ class AgeData
 
         PopType m_popType;
     public:
-        AgeData(unsigned int age, vecVecDouble& susc, vecVecDouble& exp, vecVecDouble& inf,
-                vecVecDouble& rec, vecVecDouble const& incub_r, vecVecDouble const& rec_r,
-                vecVecDouble const& fat_r, vecDouble const& vac_r, vecDouble const& immu_r, PopType type=PopType::NVAC) :
-            m_susceptible(susc.at(age)),
-            m_exposed(exp.at(age)),
-            m_infected(inf.at(age)),
-            m_recovered(rec.at(age)),
-            m_newFatalities(inf.at(age).size(), 0.0),
-            m_newRecoveries(inf.at(age).size(), 0.0),
-            m_newVacFromRec(rec.at(age).size(), 0.0),
-            m_newExposed(susc.at(age).size(), 0.0),
-            m_totalSusceptible(0.0),
-            m_totalExposed(0.0),
-            m_totalInfected(0.0),
-            m_totalFatalities(0.0),
-            m_totalRecoveries(0.0),
-            m_OriginalSusceptible(susc.at(age)),
-            m_OriginalExposed(exp.at(age)),
-            m_OriginalInfected(inf.at(age)),
-            m_OriginalRecovered(rec.at(age)),
-            m_incubRates(incub_r.at(age)),
-            m_recovRates(rec_r.at(age)),
-            m_fatalRates(fat_r.at(age)),
-            m_vacRates(vac_r),     // Don't .at() this one since it may be EMPTY_VEC
-            m_immuneRates(immu_r), // This one too may be EMPTY_VEC
+        /**
+         * @brief Scratch object of a population type, sized for the phases of a state
+         * but not pointing at any of them until Reset() is called
+         *
+         * @param state State with the shape of the states it will be reset to
+         * @param pop_type sevirds::NVAC_POP, DOSE1_POP, DOSE2_POP or BOOSTER_POP + booster index
+         * @param type Type of the population
+        */
+        AgeData(sevirds const& state, unsigned int pop_type, PopType type=PopType::NVAC) :
+            m_susceptible(nullptr, 0, nullptr),
+            m_exposed(nullptr, 0, nullptr),
+            m_infected(nullptr, 0, nullptr),
+            m_recovered(nullptr, 0, nullptr),
+            m_incubRates(&EMPTY_VEC),
+            m_recovRates(&EMPTY_VEC),
+            m_fatalRates(&EMPTY_VEC),
+            m_vacRates(&EMPTY_VEC),
+            m_immuneRates(&EMPTY_VEC),
             m_popType(type)
         {
+            // Reset() only assigns vectors of these sizes so it never has to allocate
+            m_newFatalities.reserve(state.phases(sevirds::INFECTED, pop_type, 0).size());
+            m_newRecoveries.reserve(state.phases(sevirds::INFECTED, pop_type, 0).size());
+            m_newVacFromRec.reserve(state.phases(sevirds::RECOVERED, pop_type, 0).size());
+            m_newExposed.reserve(state.phases(sevirds::SUSCEPTIBLE, pop_type, 0).size());
+        }
+
+        /**
+         * @brief Points the object at an age group of a population type and clears
+         * what was computed for the previous one. The population type must be
+         * the one the object was made for
+         *
+         * @param age Age group
+         * @param res State being computed
+         * @param pop_type sevirds::NVAC_POP, DOSE1_POP, DOSE2_POP or BOOSTER_POP + booster index
+        */
+        void Reset(unsigned int age, sevirds& res, unsigned int pop_type, vecVecDouble const& incub_r, vecVecDouble const& rec_r,
+                    vecVecDouble const& fat_r, vecDouble const& vac_r=EMPTY_VEC, vecDouble const& immu_r=EMPTY_VEC)
+        {
+            m_susceptible = res.phases(sevirds::SUSCEPTIBLE, pop_type, age);
+            m_exposed     = res.phases(sevirds::EXPOSED, pop_type, age);
+            m_infected    = res.phases(sevirds::INFECTED, pop_type, age);
+            m_recovered   = res.phases(sevirds::RECOVERED, pop_type, age);
+
+            m_newFatalities.assign(m_infected.size(), 0.0);
+            m_newRecoveries.assign(m_infected.size(), 0.0);
+            m_newVacFromRec.assign(m_recovered.size(), 0.0);
+            m_newExposed.assign(m_susceptible.size(), 0.0);
+
+            m_totalSusceptible = 0.0;
+            m_totalExposed     = 0.0;
+            m_totalInfected    = 0.0;
+            m_totalFatalities  = 0.0;
+            m_totalRecoveries  = 0.0;
+
+            m_origSusceptibleBack = m_susceptible.back();
+            m_origExposedBack     = m_exposed.back();
+            m_origInfectedBack    = m_infected.back();
+            m_origRecoveredBack   = m_recovered.back();
+
+            m_susceptibleShift = 0;
+            m_exposedShift     = 0;
+            m_infectedShift    = 0;
+            m_recoveredShift   = 0;
+
+            m_incubRates  = &incub_r.at(age);
+            m_recovRates  = &rec_r.at(age);
+            m_fatalRates  = &fat_r.at(age);
+            m_vacRates    = &vac_r;  // Don't .at() this one since it may be EMPTY_VEC
+            m_immuneRates = &immu_r; // This one too may be EMPTY_VEC
+
             // -1 so for loops are easier
             m_susceptiblePhase = m_susceptible.size() - 1;
             m_exposedPhase     = m_exposed.size()     - 1;
             m_infectedPhase    = m_infected.size()    - 1;
             m_recoveredPhase   = m_recovered.size()   - 1;
-
-            m_OriginalExposed.reserve(m_exposedPhase + 1);
-            m_OriginalInfected.reserve(m_infectedPhase + 1);
-            m_OriginalRecovered.reserve(m_recoveredPhase + 1);
-            m_newFatalities.reserve(m_infectedPhase + 1);
         }
 
-        // Non-Vaccinated
-        //  No vaccination or immunity rates
-        AgeData(unsigned int age, vecVecDouble& susc, vecVecDouble& exp, vecVecDouble& inf,
-            vecVecDouble& rec, vecVecDouble const& incub_r, vecVecDouble const& rec_r, vecVecDouble const& fat_r) :
-            AgeData(age, susc, exp, inf, rec, incub_r, rec_r, fat_r, EMPTY_VEC, EMPTY_VEC)
-        { }
-
         // GETTERS
-        double GetSusceptibleBack()     { return m_susceptible.back();         }
-        double GetRecoveredBack()       { return m_recovered.back();           }
-        double GetNewFatalitiesBack()   { return m_newFatalities.back();       }
-        double GetNewRecoveredBack()    { return m_newRecoveries.back();       }
-        double GetOrigSusceptibleBack() { return m_OriginalSusceptible.back(); }
-        double GetOrigInfectedBack()    { return m_OriginalInfected.back();    }
-        double GetOrigRecoveredBack()   { return m_OriginalRecovered.back();   }
+        double GetNewFatalitiesBack()   { return m_newFatalities.back(); }
+        double GetNewRecoveredBack()    { return m_newRecoveries.back(); }
+        double GetOrigSusceptibleBack() { return m_origSusceptibleBack;  }
+        double GetOrigExposedBack()     { return m_origExposedBack;      }
+        double GetOrigInfectedBack()    { return m_origInfectedBack;     }
+        double GetOrigRecoveredBack()   { return m_origRecoveredBack;    }
 
         double GetTotalSusceptible() { return m_totalSusceptible; }
         double GetTotalExposed()     { return m_totalExposed;     }
@@ -149,16 +186,29 @@ class AgeData
         double GetVacFromRec(int index)    { return m_newVacFromRec.at(index); }
         double GetNewExposed(int index)    { return m_newExposed.at(index);    }
 
-        double GetOrigSusceptible(int index) { return m_OriginalSusceptible.at(index); }
-        double GetOrigExposed(int index)     { return m_OriginalExposed.at(index);     }
-        double GetOrigInfected(int index)    { return m_OriginalInfected.at(index);    }
-        double GetOrigRecovered(int index)   { return m_OriginalRecovered.at(index);   }
+        /**
+         * @brief Proportion on day 'index' at timestep t. Once the phase is advanced
+         * this is only valid until day index + 1 has been set for timestep t+1
+         * 
+         * @param index Day of the phase
+         * @return double
+        */
+        double GetOrigSusceptible(unsigned int index) { return (index == m_susceptiblePhase) ? m_origSusceptibleBack : m_susceptible.at(index + m_susceptibleShift); }
+        double GetOrigExposed(unsigned int index)     { return (index == m_exposedPhase)     ? m_origExposedBack     : m_exposed.at(index + m_exposedShift);         }
+        double GetOrigInfected(unsigned int index)    { return (index == m_infectedPhase)    ? m_origInfectedBack    : m_infected.at(index + m_infectedShift);       }
+        double GetOrigRecovered(unsigned int index)   { return (index == m_recoveredPhase)   ? m_origRecoveredBack   : m_recovered.at(index + m_recoveredShift);     }
+
+        // The proportion on day q at timestep t+1 before the rates are applied to it
+        double GetSusceptible(unsigned int q) { return m_susceptible.at(q); }
+        double GetExposed(unsigned int q)     { return m_exposed.at(q);     }
+        double GetInfected(unsigned int q)    { return m_infected.at(q);    }
+        double GetRecovered(unsigned int q)   { return m_recovered.at(q);   }
 
-        double GetIncubationRate(int index)  { return m_incubRates.at(index);    }
-        double GetRecoveryRate(int index)    { return m_recovRates.at(index);    }
-        double GetFatalityRate(int index)    { return m_fatalRates.at(index);    }
-        double GetVaccinationRate(int index) { return m_vacRates.at(index);      }
-        double GetImmunityRate(int index)    { return m_immuneRates.at(index);   }
+        double GetIncubationRate(int index)  { return m_incubRates->at(index);    }
+        double GetRecoveryRate(int index)    { return m_recovRates->at(index);    }
+        double GetFatalityRate(int index)    { return m_fatalRates->at(index);    }
+        double GetVaccinationRate(int index) { return m_vacRates->at(index);      }
+        double GetImmunityRate(int index)    { return m_immuneRates->at(index);   }
 
         unsigned int GetSusceptiblePhase() { return m_susceptiblePhase; }
         unsigned int GetExposedPhase()     { return m_exposedPhase;     }
@@ -167,6 +217,23 @@ class AgeData
 
         PopType& GetType() { return m_popType; }
 
+        // ADVANCE
+        /**
+         * @brief Moves everybody in the phase forward one day without copying anything.
+         * Afterwards day q holds what was on day q - 1 at timestep t so the rates
+         * can be applied in place. Day 0 holds the old last day until it's set
+        */
+        void AdvanceSusceptible() { m_susceptible.advance(); m_susceptibleShift = 1; }
+        void AdvanceExposed()     { m_exposed.advance();     m_exposedShift     = 1; }
+        void AdvanceInfected()    { m_infected.advance();    m_infectedShift    = 1; }
+        void AdvanceRecovered()   { m_recovered.advance();   m_recoveredShift   = 1; }
+
+        /**
+         * @brief Puts the proportion of the last day at timestep t back on the last day.
+         * Used when nobody leaves or enters the last day of the phase
+        */
+        void KeepSusceptibleBack() { m_susceptible.back() = m_origSusceptibleBack; }
+
         // SETTERS
         void SetNewRecovered(unsigned int q, double value)  { m_newRecoveries.at(q) = value;  }
         void SetVacFromRec(unsigned int q, double value)    { m_newVacFromRec.at(q) = value;  }
@@ -0,0 +1,49 @@
+#ifndef PANDEMIC_HOYA_2002_CELL_REGISTRY_HPP
+#define PANDEMIC_HOYA_2002_CELL_REGISTRY_HPP
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../Helpers/Assert.hpp"
+
+using namespace std;
+
+/**
+ * Interns the string IDs of the cells (DAUIDs, PHU IDs...) to dense integer indices.
+ * Cells are numbered in the order they are first seen while the scenario is loaded,
+ * the string IDs are then only needed to log the simulation.
+*/
+class cell_registry
+{
+    unordered_map<string, unsigned int> indices;
+    vector<string> ids;
+
+    public:
+        /**
+         * @brief Gets the index of a cell, giving it the next free index if it's new
+         *
+         * @param id String ID of the cell
+         * @return unsigned int
+        */
+        unsigned int intern(string const& id)
+        {
+            auto inserted = indices.emplace(id, ids.size());
+            if (inserted.second)
+                ids.push_back(id);
+
+            return inserted.first->second;
+        }
+
+        unsigned int index(string const& id) const
+        {
+            auto it = indices.find(id);
+            Assert::AssertLong(it != indices.end(), __FILE__, __LINE__, "The cell " + id + " was never registered");
+            return it->second;
+        }
+
+        string const& id(unsigned int index) const { return ids.at(index); }
+        unsigned int size() const                  { return ids.size();    }
+}; //class cell_registry{}
+
+#endif //PANDEMIC_HOYA_2002_CELL_REGISTRY_HPP
@@ -0,0 +1,40 @@
+#ifndef PANDEMIC_HOYA_2002_CONFIG_STORE_HPP
+#define PANDEMIC_HOYA_2002_CONFIG_STORE_HPP
+
+#include <memory>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "simulation_config.hpp"
+
+using namespace std;
+
+/**
+ * Parses every distinct cell configuration of a scenario only once.
+ * The configurations are keyed by their hashed json so cells that share
+ * the same rates (usually all of them) also share one immutable copy of them.
+*/
+class config_store
+{
+    unordered_map<nlohmann::json, shared_ptr<simulation_config const>> configs;
+
+    public:
+        /**
+         * @brief Gets the parsed configuration matching the json,
+         * parsing it the first time it's seen
+         *
+         * @param config Configuration of a cell as found in the scenario
+         * @return shared_ptr<simulation_config const>
+        */
+        shared_ptr<simulation_config const> get(nlohmann::json const& config)
+        {
+            auto it = configs.find(config);
+            if (it == configs.end())
+                it = configs.emplace(config, make_shared<simulation_config const>(config.get<simulation_config>())).first;
+
+            return it->second;
+        }
+
+        unsigned int size() const { return configs.size(); }
+}; //class config_store{}
+
+#endif //PANDEMIC_HOYA_2002_CONFIG_STORE_HPP
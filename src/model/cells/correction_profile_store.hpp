@@ -0,0 +1,67 @@
+#ifndef PANDEMIC_HOYA_2002_CORRECTION_PROFILE_STORE_HPP
+#define PANDEMIC_HOYA_2002_CORRECTION_PROFILE_STORE_HPP
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "vicinity.hpp"
+#include "../Helpers/Assert.hpp"
+
+using namespace std;
+
+/**
+ * Parses every distinct set of correction factors of a scenario only once. A vicinity either
+ * holds its "infection_correction_factors" or names a profile of the optional "correction_profiles"
+ * object at the top of the scenario:
+ *   "correction_profiles": {"lockdown": {"0.001": [0.6, 0.0008], ...}},
+ *   "cells": {"id": {"neighborhood": {"neighbor": {"correlation": 0.5, "infection_correction_factors": "lockdown"}}}}
+ * Either way the vicinities with the same factors share one immutable profile.
+*/
+class correction_profile_store
+{
+    using profile_type = shared_ptr<vicinity::correction_profile const>;
+
+    unordered_map<nlohmann::json, profile_type> profiles; // Keyed by their json
+    unordered_map<string, profile_type> named;            // From "correction_profiles"
+
+    public:
+        /**
+         * @brief Adds the profiles of the "correction_profiles" object of a scenario
+         *
+         * @param json Correction factors keyed by the name of their profile
+        */
+        void add_named(nlohmann::json const& json)
+        {
+            for (auto const& profile : json.items())
+                named[profile.key()] = get(profile.value());
+        }
+
+        /**
+         * @brief Gets the profile of the "infection_correction_factors" of a vicinity,
+         * parsing it the first time it's seen
+         *
+         * @param factors Correction factors or name of a profile of "correction_profiles"
+         * @return shared_ptr<vicinity::correction_profile const>
+        */
+        profile_type get(nlohmann::json const& factors)
+        {
+            if (factors.is_string())
+            {
+                auto profile = named.find(factors.get<string>());
+                AssertLong(profile != named.end(), __FILE__, __LINE__, "Unknown correction profile " + factors.get<string>()
+                            + ", the \"correction_profiles\" of a scenario must come before its \"cells\"");
+                return profile->second;
+            }
+
+            auto it = profiles.find(factors);
+            if (it == profiles.end())
+                it = profiles.emplace(factors, parse_correction_profile(factors)).first;
+
+            return it->second;
+        }
+
+        unsigned int size() const { return profiles.size(); }
+}; //class correction_profile_store{}
+
+#endif //PANDEMIC_HOYA_2002_CORRECTION_PROFILE_STORE_HPP
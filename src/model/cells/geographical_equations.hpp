@@ -0,0 +1,1098 @@
+#ifndef PANDEMIC_HOYA_2002_GEOGRAPHICAL_EQUATIONS_HPP
+#define PANDEMIC_HOYA_2002_GEOGRAPHICAL_EQUATIONS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <vector>
+#include "vicinity.hpp"
+#include "sevirds.hpp"
+#include "simulation_config.hpp"
+#include "AgeData.hpp"
+#include "infectious_pressure.hpp"
+#include "../Helpers/Assert.hpp"
+
+using namespace std;
+using namespace Assert;
+
+// Indices for a vector used in next_state(), compute_vaccinated(),
+// and compute_EIRD()
+unsigned int const NVAC = 0;
+unsigned int const VAC1 = 1;
+unsigned int const VAC2 = 2;
+unsigned int const BOOS = 3;
+
+/**
+ * The equations computing the next state of a geographical cell. They don't depend on the simulator
+ * running them so they are shared by the Cadmium cell (geographical_cell.hpp) and the CSR engine.
+ *
+ * The neighbors are handed to next_state() as an object with the following methods, where j is the
+ * position of a neighbor in the neighborhood of the cell:
+ *  - unsigned int size()                                Number of neighbors, the cell itself included
+ *  - unsigned int self()                                Position of the cell in its own neighborhood
+ *  - infectious_pressure const& neighbor_pressure(j)    Summary of the last known state of the neighbor
+ *  - vicinity const& neighbor_vicinity(j)               Correlation and correction factors of the neighbor
+ * The summary is either published by the neighbor or made from its state with infectious_pressure_of().
+ *
+ * Everything next_state() needs besides the state it computes is kept in a scratch arena sized when the
+ * cell is loaded, so once a cell has computed a day it doesn't allocate anything anymore. The arena
+ * belongs to the equations of one cell, which is only ever computed by one thread at a time.
+ *
+ * The hysteresis of the movement restrictions of the neighbors is kept here as well, in the order of the
+ * neighborhood, rather than in the state: it is only ever read by the cell itself so its neighbors don't need it.
+ * next_state() leaves the hysteresis of the day it computes aside, the simulator moves it on with commit()
+ * when it keeps the new state, so computing a day again gives the same state.
+*/
+class geographical_equations
+{
+    public:
+        using config_type = shared_ptr<simulation_config const>;
+
+        using phase_rates = simulation_config::phase_rates;
+
+        // Rates shared with every other cell using the same configuration
+        config_type config;
+
+        bool reSusceptibility, is_vaccination;
+
+        unsigned int age_segments;
+
+        double prec_divider, one_over_prec_divider;
+
+        geographical_equations() = default;
+
+        /**
+         * @brief Sets up the equations of a cell and the parts of its initial state that come from the configuration
+         *
+         * @param initial_state State the cell starts the simulation in
+         * @param num_neighbors Size of the neighborhood of the cell, itself included
+         * @param config Rates of the cell
+        */
+        geographical_equations(sevirds& initial_state, unsigned int num_neighbors, config_type config) : config{move(config)}
+        {
+            hysteresis.assign(num_neighbors, hysteresis_factor{});
+            scratch.hysteresis = hysteresis;
+
+            // Set whether or not vaccines are being modeled
+            // to be used in the getters found in sevirds.hpp
+            // and later in this file
+            is_vaccination         = this->config->is_vaccination;
+            initial_state.vaccines = is_vaccination;
+
+            // Set the precision divider in the sevirds object
+            // Multiplication is always faster then division so set this up to be 1/prec_divider to be multiplied later
+            prec_divider                        = (double)this->config->prec_divider;
+            one_over_prec_divider               = 1.0 / prec_divider;
+            initial_state.prec_divider          = prec_divider;
+            initial_state.one_over_prec_divider = one_over_prec_divider;
+
+            reSusceptibility  = this->config->reSusceptibility;
+            age_segments = initial_state.get_num_age_segments();
+
+            if (is_vaccination)
+            {
+                unsigned int num_boosters = initial_state.num_boosters();
+                AssertLong(this->config->boosters_incubation_rates.size() == num_boosters || this->config->boosters_recovery_rates.size() == num_boosters
+                            || this->config->boosters_fatality_rates.size() == num_boosters || this->config->boosters_vaccination_rates.size() == num_boosters,
+                            __FILE__, __LINE__, "Error attempting to set incubation, recovery, fatality, and/or vaccination rates.\nVerify that each booster shot has matching rates in  default.json");
+            }
+
+            // One AgeData per population type, see next_state()
+            scratch.datas.emplace_back(initial_state, sevirds::NVAC_POP);
+            if (is_vaccination)
+            {
+                scratch.datas.emplace_back(initial_state, sevirds::DOSE1_POP, AgeData::PopType::DOSE1);
+                scratch.datas.emplace_back(initial_state, sevirds::DOSE2_POP, AgeData::PopType::DOSE2);
+                for (unsigned int i = 0; i < initial_state.num_boosters(); ++i)
+                    scratch.datas.emplace_back(initial_state, sevirds::BOOSTER_POP + i, AgeData::PopType::BOOSTER);
+
+                scratch.early_vac2.reserve(initial_state.phases(sevirds::SUSCEPTIBLE, sevirds::DOSE1_POP, 0).size());
+                scratch.early_boos.reserve(initial_state.phases(sevirds::SUSCEPTIBLE, sevirds::DOSE2_POP, 0).size());
+            }
+
+            // The totals depend on the precision set above, and the non-const accessors used above drop them
+            initial_state.update_totals();
+        }
+
+        /**
+         * @brief Switches the cell to other rates in the middle of a simulation. Whether vaccines are modelled
+         * and the precision are part of the state of the cell so they can't change, nor can the number of phase days
+         *
+         * @param new_config Rates of the cell from now on
+        */
+        void use_config(config_type new_config)
+        {
+            AssertLong(new_config->is_vaccination == is_vaccination && (double)new_config->prec_divider == prec_divider,
+                        __FILE__, __LINE__, "The vaccines and the precision of a cell can't change during a simulation");
+
+            config           = move(new_config);
+            reSusceptibility = config->reSusceptibility;
+        }
+
+        /**
+         * @brief This is the 'main' function for the class
+         * and is where all the equations for the the current cell
+         * and on the current day are computed for each age group
+         *
+         * @param current_state State of the cell at the end of the previous day
+         * @param neighborhood States and vicinities of the neighbors of the cell
+         * @param day Day being computed
+         * @return sevirds
+        */
+        template <typename NEIGHBORHOOD>
+        sevirds next_state(sevirds const& current_state, NEIGHBORHOOD const& neighborhood, double day) const
+        {
+            sevirds res = current_state;
+            next_state(current_state, neighborhood, day, res);
+            return res;
+        }
+
+        /**
+         * @brief Same as above but overwrites a state rather than returning a new one.
+         * As long as that state has the shape of the cell's states, e.g. it is one of its
+         * previous states, nothing is allocated once the cell has computed a first day.
+         *
+         * The simulators only keep the new state when it's different from the current one,
+         * and then call commit() so the hysteresis of the cell moves on along with its state
+         *
+         * @param current_state State of the cell at the end of the previous day
+         * @param neighborhood States and vicinities of the neighbors of the cell
+         * @param day Day being computed
+         * @param res Overwritten with the state of the cell at the end of the day
+         * @return bool Is the new state different from the current one?
+        */
+        template <typename NEIGHBORHOOD>
+        bool next_state(sevirds const& current_state, NEIGHBORHOOD const& neighborhood, double day, sevirds& res) const
+        {
+            // Only kept to report the day a proportion went out of bounds
+            this->day = day;
+
+            res = current_state;
+
+            // One AgeData object for non-vac, dose1, dose2, and any booster shot populations
+            vector<AgeData>& datas = scratch.datas;
+
+            // The neighborhood sum used by every new exposure equation is the same for
+            // all age groups, population types and phase days so only compute it once
+            scratch.hysteresis = hysteresis;
+            double force_of_infection = neighborhood_force_of_infection(res, neighborhood, scratch.hysteresis);
+
+            // Without infections in the cell nor in its neighborhood every new exposure, infection, recovery
+            // from an infection and fatality is exactly zero, so only the vaccinations and the recovered phases move
+            bool quiet = force_of_infection == 0 && res.is_free_of_infection();
+
+            // Global new susceptible variable as the other equations
+            // remove their proportions from this one leaving it with
+            // the remaning susceptible proportion
+            double new_s;
+
+            // Calculate the next new sevirds variables for each age group
+            for (unsigned int age_segment_index = 0; age_segment_index < age_segments; ++age_segment_index)
+            {
+                // Reset for susceptible equation
+                new_s = 1;
+
+                // Init the non-vac object for the current age group
+                datas.at(NVAC).Reset(age_segment_index, res, sevirds::NVAC_POP,
+                                    config->incubation_rates, config->recovery_rates, config->fatality_rates);
+
+                if (is_vaccination)
+                {
+                    // Init the vac object for the current age group
+                    datas.at(VAC1).Reset(age_segment_index, res, sevirds::DOSE1_POP,
+                                        config->incubationD1_rates, config->recovery_ratesD1,
+                                        config->fatality_ratesD1, config->vac1_rates.at(age_segment_index),
+                                        res.immunityD1_rate(age_segment_index));
+                    datas.at(VAC2).Reset(age_segment_index, res, sevirds::DOSE2_POP,
+                                        config->incubationD2_rates, config->recovery_ratesD2,
+                                        config->fatality_ratesD2, config->vac2_rates.at(age_segment_index),
+                                        res.immunityD2_rate(age_segment_index));
+
+                    // Init the boosters and their age relevant data
+                    for (unsigned int i = 0; i < res.num_boosters(); ++i)
+                    {
+                        datas.at(BOOS + i).Reset(age_segment_index, res, sevirds::BOOSTER_POP + i,
+                                                config->boosters_incubation_rates.at(i), config->boosters_recovery_rates.at(i),
+                                                config->boosters_fatality_rates.at(i), config->boosters_vaccination_rates.at(i).at(age_segment_index),
+                                                res.boosters_immunity_rates(i, age_segment_index));
+                    }
+
+                    // Equations for Vaccinated population (eg. EV1, RV2...)
+                    sanity_check(res.get_total_susceptible(true, age_segment_index), __LINE__);
+                    compute_vaccinated(datas, res, force_of_infection, quiet);
+
+                    // S = 1 - V1 - V2
+                    new_s -= datas.at(VAC1).GetTotalSusceptible(); // 1e
+                    sanity_check(new_s, __LINE__);
+                    new_s -= datas.at(VAC2).GetTotalSusceptible(); // 2d
+                    sanity_check(new_s, __LINE__);
+                }
+
+                // Compute the Exposed, Infected, Recovered, and Fatalities equations
+                // for all population types
+                compute_EIRD(datas, res, force_of_infection, quiet);
+
+                // S = 1 - E - I - R - F
+                for (AgeData& data : datas)
+                {
+                    new_s -= data.GetTotalExposed();
+                    sanity_check(new_s, __LINE__);
+                    new_s -= data.GetTotalInfected();
+                    sanity_check(new_s, __LINE__);
+                    new_s -= data.GetTotalRecovered();
+                    sanity_check(new_s, __LINE__);
+
+                    res.fatalities(age_segment_index) += data.GetTotalFatalities();
+                    sanity_check(res.fatalities(age_segment_index), __LINE__);
+                }
+
+                new_s -= res.fatalities(age_segment_index);
+                sanity_check(new_s, __LINE__);
+
+                res.susceptible(age_segment_index).front() = new_s;
+            } //for(age_groups)
+
+            // The state is final, its totals are read by the logs and the neighbors from now on
+            res.update_totals();
+
+            bool changed = res != current_state;
+            scratch.changed = changed;
+
+            return changed;
+        } //next_state()
+
+        /**
+         * @brief Vaccinated Dose 1 - Equation 1a
+         * 
+         * @param datas Vector containing the three population types and their data
+         * @param res State machine object that holds simulation config data
+         * @return double
+         */
+        double new_vaccinated1(vector<AgeData>& datas, sevirds const& res) const
+        {
+            // Vaccination rate with those who are susceptible
+            // vd1 * S
+            double new_vac1 = datas.at(VAC1).GetVaccinationRate(0)  // vd1
+                            * datas.at(NVAC).GetOrigSusceptible(0); // * S
+
+            // And those who are in the recovery phase
+            double sum = 0;
+            for (unsigned int q = datas.at(NVAC).GetRecoveredPhase() - 1; q > res.min_interval_recovery_to_vaccine; --q)
+            {
+                // Remember these values in the non-vac object as
+                // they are removed from the susceptible group
+                // in increment_recoveries(). Only do math once!!
+                datas.at(NVAC).SetVacFromRec(q - 1,
+                                                    datas.at(NVAC).GetOrigRecovered(q - 1) // R(q)
+                                                    * datas.at(VAC1).GetVaccinationRate(0) // vd1
+                );
+
+                sum += datas.at(NVAC).GetVacFromRec(q - 1);
+            }
+
+            return new_vac1 + sum;
+        }
+
+        /**
+         * @brief Vaccinated Dose 2 - Equation 2a
+         * 
+         * @param datas Vector containing the three population types with their respective data
+         * @param res Current state of the cell
+         * @param force_of_infection Neighborhood sum computed by neighborhood_force_of_infection()
+         * @param quiet Is nobody exposed to an infection? (see next_state())
+         * @return double
+         */
+        double new_vaccinated2(vector<AgeData>& datas, sevirds& res, vecDouble const& earlyVac2, double force_of_infection, bool quiet) const
+        {
+            AgeData& age_data_vac1 = datas.at(VAC1);
+            AgeData& age_data_vac2 = datas.at(VAC2);
+
+            // Everybody on the last day of dose 1 is moved to dose 2
+            double vac2 = age_data_vac1.GetOrigSusceptibleBack(); // V1(td1)
+
+            // Some people are eligible to receive their second dose sooner
+            // and this was already computed ealier in compute_vaccinated()
+            // qϵ{mtd1...td1 - 1}
+            vac2 += accumulate(earlyVac2.begin(), earlyVac2.end(), 0.0);
+
+            // Some people are eligible to receive their second dose sooner from the dose 1 recovery pop
+            // qϵ{mtd1...Tr}
+            for (unsigned int q = age_data_vac1.GetRecoveredPhase(); q > res.min_interval_recovery_to_vaccine; --q)
+            {
+                // Remember these values for when they are removed from the
+                // vac1 susceptible group in increment_recoveries()
+                age_data_vac1.SetVacFromRec(q - 1,
+                                            age_data_vac2.GetVaccinationRate(q - 1 - res.min_interval_recovery_to_vaccine) // v(q)
+                                                * age_data_vac1.GetOrigRecovered(q - 1)                                    // RV1(q)
+                );
+
+                vac2 += age_data_vac1.GetVacFromRec(q - 1);
+            }
+
+            if (quiet)
+                return vac2;
+
+            // - V1(td1) * sum(1...k and 1...Ti))
+                return vac2 - new_exposed(force_of_infection, datas.at(VAC1), age_data_vac1.GetSusceptiblePhase());
+        }
+        /**
+         * @brief Vaccinated Dose Booster - Equation 3a
+         * 
+         * @param datas Vector containing the three population types with their respective data
+         * @param res Current state of the cell
+         * @param force_of_infection Neighborhood sum computed by neighborhood_force_of_infection()
+         * @param quiet Is nobody exposed to an infection? (see next_state())
+         * @return double
+         */
+        double new_vaccinatedB(vector<AgeData>& datas, sevirds& res, vecDouble const& earlyBoos, double force_of_infection, bool quiet) const
+        {
+            AgeData& age_data_vac2 = datas.at(VAC2);
+            AgeData& age_data_boos = datas.at(BOOS);
+
+            // Everybody on the last day of dose 2 is moved to booster
+            double booster = age_data_vac2.GetOrigSusceptibleBack(); // V2(td2)
+
+            //Sum up those who got the booster earlier from Vac2
+            booster += accumulate(earlyBoos.begin(), earlyBoos.end(), 0.0);
+            
+            // Some people are eligible to receive their booster sooner from the dose 2 recovery pop
+            // qϵ{mtd1...Tr}
+            for (unsigned int q = age_data_vac2.GetRecoveredPhase(); q > res.min_interval_recovery_to_vaccine; --q)
+            {
+                // Remember these values for when they are removed from the
+                // vac2 susceptible group in increment_recoveries()
+                age_data_vac2.SetVacFromRec(q - 1,
+                                            age_data_boos.GetVaccinationRate(q - 1 - res.min_interval_recovery_to_vaccine) // v(q)
+                                                * age_data_vac2.GetOrigRecovered(q - 1)                                    // RV2(q)
+                );
+
+                booster += age_data_vac2.GetVacFromRec(q - 1);
+            }
+
+            if (quiet)
+                return booster;
+
+            // - V2(td2) * sum(1...k and 1...Ti))
+                return booster - new_exposed(force_of_infection, datas.at(VAC2), age_data_vac2.GetSusceptiblePhase());
+        }
+        /**
+         * @brief Summarizes a state into what a neighbor needs to compute its force of infection:
+         * the total infections, the disobedient proportion and the infections of each age group
+         * weighted by the mobility and virulence rates of this cell
+         *
+         * @param nstate State to summarize
+         * @param pressure Summary to fill, its vectors are reused
+        */
+        void infectious_pressure_of(sevirds const& nstate, infectious_pressure& pressure) const
+        {
+            double inner_sum = 0, inner_sumV1 = 0, inner_sumV2 = 0;
+
+            phase_rates const& mobility_rates  = config->mobility_rates;
+            phase_rates const& virulence_rates = config->virulence_rates;
+
+            pressure.total_infections      = nstate.total_infections();
+            pressure.disobedient           = nstate.disobedient;
+            pressure.age_group_proportions = nstate.age_group_proportions();
+            pressure.weighted_infections.resize(nstate.num_age_groups);
+
+            // bϵ{1...A}
+            for (unsigned int age_group = 0; age_group < nstate.num_age_groups; ++age_group)
+            {
+
+                // nϵ{1...Ti}
+                const_phase_ring infected = nstate.infected(age_group);
+                for (unsigned int n = 0; n < infected.size(); ++n)
+                {
+                    inner_sum +=
+                            mobility_rates.at(age_group).at(n)    // μ(n)
+                            * virulence_rates.at(age_group).at(n) // λ(n)
+                            * infected.at(n)                      // I(n)
+                        ;
+                }
+
+                if (is_vaccination)
+                {
+                    // nϵ{1...Ti,V1}
+                    const_phase_ring infectedD1 = nstate.infectedD1(age_group);
+                    for (unsigned int n = 0; n < infectedD1.size(); ++n)
+                    {
+                        inner_sumV1 +=
+                                mobility_rates.at(age_group).at(n)      // μ(n)
+                                * virulence_rates.at(age_group).at(n)   // λ(n)
+                                * infectedD1.at(n)                      // IV1(n)
+                            ;
+                    }
+
+                    // nϵ{1...Ti,V2}
+                    const_phase_ring infectedD2 = nstate.infectedD2(age_group);
+                    for (unsigned int n = 0; n < infectedD2.size(); ++n)
+                    {
+                        inner_sumV2 +=
+                            mobility_rates.at(age_group).at(n)      // μ(n)
+                            * virulence_rates.at(age_group).at(n)   // λ(n)
+                            * infectedD2.at(n)                      // IV2(n)
+                            ;
+                    }
+                }
+
+                pressure.weighted_infections.at(age_group) = inner_sum + inner_sumV1 + inner_sumV2; // sum(1...Ti)
+            }
+        } //infectious_pressure_of()
+
+        /**
+         * @brief Same as above but fills the summary kept in the scratch arena of the cell,
+         * which is overwritten by the next call
+         *
+         * @param nstate State to summarize
+         * @return infectious_pressure const&
+        */
+        infectious_pressure const& infectious_pressure_of(sevirds const& nstate) const
+        {
+            infectious_pressure_of(nstate, scratch.pressure);
+            return scratch.pressure;
+        }
+
+        /**
+         * @brief Whether the summaries made by infectious_pressure_of() are the same for both equations,
+         * in which case a cell can publish its own summary instead of its neighbors computing it
+         *
+         * @param other Equations of another cell
+         * @return bool
+        */
+        bool same_infectious_pressure(geographical_equations const& other) const
+        {
+            return config == other.config
+                   || (is_vaccination == other.is_vaccination
+                       && config->mobility_rates == other.config->mobility_rates
+                       && config->virulence_rates == other.config->virulence_rates);
+        }
+
+        /**
+         * @brief Force of infection the neighborhood exerts on the current cell.
+         * It doesn't depend on the population type, age group or phase day so it is computed
+         * once per local_computation() and shared by every new_exposed() call
+         * 
+         * @param res State machine object that holds simulation config data
+         * @param neighborhood Infectious pressures and vicinities of the neighbors (see next_state())
+         * @param hysteresis_factors Hysteresis of each neighbor, updated with the restrictions in effect
+         * @return double sum(jϵ{1...k} cij * kij * sum(bϵ{1...A}, nϵ{1...Ti}))
+        */
+        template <typename NEIGHBORHOOD>
+        double neighborhood_force_of_infection(sevirds const& res, NEIGHBORHOOD const& neighborhood, vector<hysteresis_factor>& hysteresis_factors) const
+        {
+            double sum = 0;
+
+            // Calculate the correction factor of the current cell.
+            // The current cell must be part of its own neighborhood for this to work!
+            unsigned int self = neighborhood.self();
+            vicinity const& self_vicinity = neighborhood.neighbor_vicinity(self);
+            double current_cell_correction_factor = res.disobedient
+                                                    + (1 - res.disobedient)
+                                                    * movement_correction_factor(self_vicinity,
+                                                                                neighborhood.neighbor_pressure(self).total_infections,
+                                                                                hysteresis_factors[self]);
+
+            double neighbor_correction;
+
+            // jϵ{1...k}
+            for (unsigned int j = 0; j < neighborhood.size(); ++j)
+            {
+                infectious_pressure const& npressure = neighborhood.neighbor_pressure(j); // Summary of cell j's state
+                vicinity const& v                    = neighborhood.neighbor_vicinity(j); // Holds cij and a correction factor used in kij
+
+                // Disobedient people have a correction factor of 1. The rest of the population is affected by the movement_correction_factor
+                neighbor_correction = npressure.disobedient
+                                        + (1 - npressure.disobedient)
+                                        * movement_correction_factor(v,
+                                                                    npressure.total_infections,
+                                                                    hysteresis_factors[j]);
+
+                // Logically makes sense to require neighboring cells to follow the movement restriction that is currently
+                // in place in the current cell if the current cell has a more restrictive movement.
+                neighbor_correction = min(current_cell_correction_factor, neighbor_correction);
+
+                // bϵ{1...A}
+                for (unsigned int age_group = 0; age_group < npressure.weighted_infections.size(); ++age_group)
+                {
+                    sum += v.correlation                                // cij
+                           * neighbor_correction                        // kij
+                           * npressure.weighted_infections[age_group]   // sum(1...Ti)
+                           * npressure.age_group_proportions[age_group] // Njb / Nj
+                        ;
+                }
+            }
+
+            return sum;
+        } //neighborhood_force_of_infection()
+
+        /**
+         * @brief Calculates proportion of new exposures from either non-vac or vac (dose 1 or 2) population.
+         * 1b, 1c, 1d, 1e, 1f, 2b, 2c, 2d, 2e, 3a, 3b and 3c use this
+         * 
+         * @param force_of_infection Neighborhood sum computed by neighborhood_force_of_infection()
+         * @param age_data Reference to current simulation data
+         * @param q Index to compute equation
+         * @return double
+        */
+        double new_exposed(double force_of_infection, AgeData& age_data, int q=0) const
+        {
+            double expos = age_data.GetOrigSusceptible(q) * force_of_infection; // S * sum(1...k)
+
+            if (age_data.GetType() != AgeData::PopType::NVAC)
+                expos *= 1.0 - age_data.GetImmunityRate( int((q - 1) * 0.14f) ); // 1 - i(q)
+
+            sanity_check(expos, __LINE__);
+            return expos;
+        } //new_exposed()
+
+        /**
+         * @brief Exposed: E(q), EV1(q), EV2(q)
+         *  Advance all exposed forward a day, with some proportion leaving exposed(q-1) and entering infected(1)
+         * 
+         * @param age_data Reference to current simulation data for current age group (nvac, dose1, dose2) and age group
+        */
+        void increment_exposed(AgeData& age_data) const
+        {
+            double curr_expos;
+
+            // Moves each proportion group in the phase to the next day
+            age_data.AdvanceExposed();
+
+            // qϵ{2...Te}
+            for (unsigned int q = age_data.GetExposedPhase(); q > 0; --q)
+            {
+                // Removes those who become infected earlier via the incubation rate
+                curr_expos = (1 - age_data.GetIncubationRate(q - 1)) // 1 - ε(q - 1)
+                             * age_data.GetExposed(q)                // * E(q - 1), already moved to day q
+                    ;
+
+                sanity_check(curr_expos, __LINE__);
+                age_data.SetExposed(q, curr_expos);
+            }
+        }
+
+        /**
+         * @brief Infection: I(1), IV1(1), or IV2(1)
+         *  Calculates proportion of new infections from either non-vac or vac (dose 1 or 2) population
+         * 
+         * @param age_data Reference to current simulation data
+         * @return double
+        */
+        double new_infections(AgeData& age_data) const
+        {
+            double inf = 0;
+
+            /* Scan through all exposed days and calculate exposed.at(age).at(q)
+            *   Incubation Rate on Te must be 1.0
+            *   Note: age_data.GetOrigExposed(i) == exposed.at(age).at(q) 
+            *   and at timestep t not t+1 so this must run before increment_exposed()
+            *   qϵ{1...Te-1}
+            */
+            for (unsigned int q = 1; q <= age_data.GetExposedPhase(); ++q)
+            {
+                // Calculates those who move early to the infected phase
+                // and automatically moves those on the last day to the infected phase
+                inf += age_data.GetIncubationRate(q) // ε(q), εV1(q), or εV2(q)
+                       * age_data.GetOrigExposed(q)  // E(q), EV1(q), or EV2(q)
+                    ;
+            }
+
+            sanity_check(inf, __LINE__);
+            return inf;
+        }
+
+        /**
+         * @brief Infectd: I(q), IV1(q), IV2(q)
+         *  Advances all infected forward a day, with some already moved to fatalities or recovered prior
+         * 
+         * @param age_data Reference to current simulation data for current age group (nvac, dose1, dose2) and age group
+         * @param recovered Vector of new recoveries from each day
+        */
+        void increment_infections(AgeData& age_data) const
+        {
+            double curr_inf;
+
+            // Moves each proportion group in the phase to the next day
+            age_data.AdvanceInfected();
+
+            // qϵ{2...Ti}
+            for (unsigned int q = age_data.GetInfectedPhase(); q > 0; --q)
+            {
+                // The previous day of infections minus those
+                // who have died and those who have recovered
+                curr_inf = age_data.GetInfected(q)            // I(q - 1), already moved to day q
+                           - age_data.GetNewFatalities(q - 1) // - D(q - 1)
+                           - age_data.GetNewRecovered(q - 1)  // - R(q - 1)
+                    ;
+
+                sanity_check(curr_inf, __LINE__);
+                age_data.SetInfected(q, curr_inf);
+            }
+        }
+
+        /**
+         * @brief Recovered: R(1), RV1(1), or RV2(1)
+         *  Calculates proportion of new new recoveries from either non-vac or vac (dose 1 or 2) population
+         * 
+         * @param age_data Reference to simulation data for the current age group and population type
+         * @return double
+        */
+        double new_recoveries(AgeData& age_data) const
+        {
+            // Assume that any individuals that are not fatalities on the last stage of infection recover
+            double recoveries = age_data.GetOrigInfectedBack()    // I(q)
+                                - age_data.GetNewFatalitiesBack() // - D(q)
+                ;
+
+            sanity_check(recoveries, __LINE__);
+            age_data.SetNewRecovered(age_data.GetInfectedPhase(), recoveries);
+
+            // qϵ{1...Ti - 1}
+            double sum;
+            for (unsigned int q = 0; q <= age_data.GetInfectedPhase() - 1; ++q)
+            {
+                // Calculate all of the new recoveries for every day that a population is infected, some recover
+                sum = age_data.GetRecoveryRate(q)   // γ(q)
+                      * age_data.GetOrigInfected(q) // I(q)
+                    ;
+
+                recoveries += sum;
+                age_data.SetNewRecovered(q, sum);
+            }
+
+            sanity_check(recoveries, __LINE__);
+            return recoveries;
+        }
+
+        /**
+         * @brief Infectd: R(q), RV1(q), RV2(q)
+         *  Advances all infected forward a day, with some already moved to fatalities or recovered prior
+         * 
+         * @param age_data Reference to current simulation data for current age group (nvac, dose1, dose2) and age group
+         * @param recovered_index If res-susc is turned on this will avoid processing the population on the last day
+         * @param age_data_vac Pointer to a vaccinated age_data object that is used for R(q) and RV1(q)
+         * @param res Used to get the minimum interval between doses needed in RV1(q)
+        */
+        void increment_recoveries(AgeData& age_data) const
+        {
+            double curr_rec;
+
+            // Moves each proportion group in the phase to the next day
+            age_data.AdvanceRecovered();
+
+            // qϵ{2...Tr}
+            for (unsigned int q = age_data.GetRecoveredPhase(); q > 0; --q)
+            {
+                curr_rec = 0;
+
+                // When resusceptibility is off then those who are recovered stay in that phase
+                if (!reSusceptibility && q == age_data.GetRecoveredPhase())
+                    curr_rec += age_data.GetOrigRecoveredBack();
+
+                // Each day of the recovered phase is the value of the previous day. The population on the last day is
+                // now susceptible (assuming a re-susceptible model); this is implicitly done already as the susceptible value was set to 1.0 and the
+                // population on the last day of recovery is never subtracted from the susceptible value.
+                // 5d, 5e, 5f
+                curr_rec += age_data.GetRecovered(q) - age_data.GetVacFromRec(q - 1); // R(q - 1) * (1 - vd(q - 1)), already moved to day q
+
+                sanity_check(curr_rec, __LINE__);
+                age_data.SetRecovered(q, curr_rec);
+            }
+        }
+
+        /**
+         * @brief New fatalities for one population group (Non-Vaccinated/Vaccinated Dose 1/Vaccinvated Dose 2)
+         *  These are calculated individually as the vector of new fatalities is used by the functions
+         *  that follow this one (see compute_vaccinated() and compute_not_vaccinated()). If we calculated
+         *  the global number of fatalities later when we do something like dose1.infected().at(q) - fatalities.at(q)
+         *  to get the maximum number of possible recoveries the fatality number will be including those from dose 2 and
+         *  not vaccinated when in reality the maximum number of recoveries for dose1 is limited to those who are infected
+         *  with dose 1 and still alive so we only want to remove those who are dose 1 fatality.
+         *
+         * @param res State of the geographical cell (holds some global data)
+         * @param age_data Contains the data of the proportion. In this function the infections proportion as well as
+         *                  the fatality rates are used from here
+         * @return double
+        */
+        double new_fatalities(sevirds const& res, AgeData& age_data) const
+        {
+            double new_f = 0.0, sum;
+
+            // The state is being computed so its totals aren't up to date, the phases are summed instead.
+            // Nothing changes the infections during the loop so they're only summed once
+            bool hospitals_full = res.get_total_infections() > res.hospital_capacity;
+
+            // Calculate all those who have died during an infection stage.
+            // qϵ{1...Ti}
+            for (unsigned int q = 0; q <= age_data.GetInfectedPhase(); ++q)
+            {
+                // fa(q) * I(q)
+                sum = age_data.GetFatalityRate(q) * age_data.GetOrigInfected(q);
+
+                // Amplify fatality rate if the hospitals are full
+                if (hospitals_full)
+                    sum *= res.fatality_modifier;
+
+                new_f += sum;
+                age_data.SetNewFatalities(q, sum);
+            }
+
+            sanity_check(new_f, __LINE__);
+            return new_f;
+        }
+
+        /**
+         * @brief Proportion of the population still moving around given the infections of a cell
+         *
+         * @param v Vicinity holding the correction factors, sorted by infection threshold
+         * @param infectious_population Total infections of the cell
+         * @param hysteresisFactor Restriction kept in effect until the infections leave its hysteresis bounds
+         * @return double
+        */
+        double movement_correction_factor(vicinity const& v, double infectious_population, hysteresis_factor& hysteresisFactor) const
+        {
+            // For example, assume a correction factor of "0.4": [0.2, 0.1]. If the infection goes above 0.4, then the
+            // correction factor of 0.2 will now be applied to total infection values above 0.3, no longer 0.4 as the
+            // hysteresis is in effect.
+            if (infectious_population > hysteresisFactor.infections_higher_bound)
+                hysteresisFactor.in_effect = false;
+
+            // This is uses the comparison '>', not '>=' ; otherwise if the lower bound is 0 there is no way for the hysteresis
+            // to disappear as the infections can never go below 0
+            if (hysteresisFactor.in_effect && infectious_population > hysteresisFactor.infections_lower_bound)
+                return hysteresisFactor.mobility_correction_factor;
+
+            hysteresisFactor.in_effect = false;
+
+            // The correction factor with the highest threshold reached, found by a binary search
+            vicinity::correction_factor const* factor = v.correction_factor_for(infectious_population);
+            if (factor == nullptr)
+                return 1.0;
+
+            // A hysteresis factor will be in effect until the total infection goes below the hysteresis factor,
+            // or above the threshold of the next correction factor (see vicinity::make_correction_factors())
+            hysteresisFactor.in_effect                  = true;
+            hysteresisFactor.infections_higher_bound    = factor->infections_higher_bound;
+            hysteresisFactor.infections_lower_bound     = factor->infections_lower_bound;
+            hysteresisFactor.mobility_correction_factor = factor->factor.front();
+
+            return factor->factor.front();
+        } //movement_correction_factor()
+
+        /**
+         * @brief Computes all the equations specific to the vaccinated population
+         * 
+         * @param datas Vector of AgeData objects containing current age group data
+         * @param res The current state of the geographical cell
+         * @param force_of_infection Neighborhood sum computed by neighborhood_force_of_infection()
+         * @param quiet Is nobody exposed to an infection? The exposures are then skipped (see next_state())
+        */
+        void compute_vaccinated(vector<AgeData>& datas, sevirds& res, double force_of_infection, bool quiet) const
+        {
+            double curr_vac1 = 0.0, curr_vac2 = 0.0, curr_boos = 0.0;
+
+            AgeData& age_data_vac1 = datas.at(VAC1);
+            AgeData& age_data_vac2 = datas.at(VAC2);
+            AgeData& age_data_boos = datas.at(BOOS);
+
+            // Holds those who get their second dose earlier from the susceptible dose 1 group, and booster from susceptible dose 2 group
+            // This is not the same as vacFromRec in AgeData.hpp
+            vecDouble& earlyVac2 = scratch.early_vac2;
+            vecDouble& earlyBoos = scratch.early_boos;
+            earlyVac2.assign(age_data_vac1.GetSusceptiblePhase(), 0.0);
+            earlyBoos.assign(age_data_vac2.GetSusceptiblePhase(), 0.0);
+
+            // <VACCINATED DOSE 1>
+                // Calculate the number of new vaccinated dose 1
+                double new_vac1 = new_vaccinated1(datas, res); // 1a
+
+                // Moves everybody forward a day, V1(q - 1) is now on day q
+                age_data_vac1.AdvanceSusceptible();
+
+                // qϵ{2...td1}
+                for (unsigned int q = age_data_vac1.GetSusceptiblePhase(); q > 0; --q)
+                {
+                    // 1b & 1d
+                    curr_vac1 = age_data_vac1.GetOrigSusceptible(q - 1); // V1(q - 1)
+
+                    if (!quiet)
+                    {
+                        age_data_vac1.SetNewExposed(q, new_exposed(force_of_infection, age_data_vac1, q - 1));
+                        curr_vac1 -= age_data_vac1.GetNewExposed(q); // - ( V1(q - 1) * (1 - iv1(q - 1)) * sum(1..k and 1...Ti) )
+                    }
+
+                    // Early dose 2
+                    if (q > res.min_interval_doses)
+                    {
+                        // 1d
+                        if (q > res.min_interval_recovery_to_vaccine)
+                            earlyVac2.at(q - 1) = age_data_vac2.GetVaccinationRate(q - 1 - res.min_interval_recovery_to_vaccine) // vd2(q - 1)
+                                                * age_data_vac1.GetOrigSusceptible(q - 1)                                        // * V1(q - 1)
+                            ;
+                        // 1c substracts early dose2 vaccinations from 1b
+                        else
+                            earlyVac2.at(q - 1) = age_data_vac2.GetVaccinationRate(q - 1 - res.min_interval_doses) // vd2(q - 1)
+                                                * age_data_vac1.GetOrigSusceptible(q - 1)                          // * V1(q - 1)
+                            ;
+
+                        curr_vac1 -= earlyVac2.at(q - 1);
+                    }
+
+                    sanity_check(curr_vac1, __LINE__);
+
+                    // Update the current day with the modified exposed from yesterday
+                    age_data_vac1.SetSusceptible(q, curr_vac1);
+                }
+
+                // 1d
+                if (reSusceptibility)
+                {
+                    double susc_from_rec = age_data_vac1.GetOrigRecoveredBack()                                                                             // RV1(Tr)
+                                        * (1 - age_data_vac2.GetVaccinationRate(age_data_vac1.GetRecoveredPhase() - res.min_interval_recovery_to_vaccine)); // * (1 - vd2(Tr))
+                    age_data_vac1.AddSusceptibleBack(susc_from_rec);
+                }
+
+                // Set the new dose1 proportion to the beginning of the phase
+                age_data_vac1.SetSusceptible(0, new_vac1);
+                sanity_check(age_data_vac1.GetTotalSusceptible(), __LINE__);
+            // </VACCINATED DOSE 1>
+
+            // <VACCINATED DOSE 2>
+                // Calculate the number of new vaccinated dose 2
+                double new_vac2 = new_vaccinated2(datas, res, earlyVac2, force_of_infection, quiet);
+                sanity_check(new_vac2, __LINE__);
+
+                // Moves everybody forward a day, V2(q - 1) is now on day q
+                age_data_vac2.AdvanceSusceptible();
+                
+                // qϵ{2...td2 - 1}
+                for (unsigned int q = age_data_vac2.GetSusceptiblePhase()-1; q > 0; --q)
+                {
+                    // 2b
+                    curr_vac2 = age_data_vac2.GetOrigSusceptible(q - 1); // V2(q - 1)
+
+                    if (!quiet)
+                    {
+                        age_data_vac2.SetNewExposed(q, new_exposed(force_of_infection, age_data_vac2, q - 1));
+                        curr_vac2 -= age_data_vac2.GetNewExposed(q); // - V2(q - 1) * (1 - iv2(q - 1)) * sum( jϵ{1…k}(cij * kij * sum(bϵ{1...A} and nϵ{1...Ti}[...])) )
+                    }
+                    // Early booster
+                    if (q > res.min_interval_doses)
+                    {
+                        // 2d
+                        if (q > res.min_interval_recovery_to_vaccine)
+                            earlyBoos.at(q - 1) = age_data_boos.GetVaccinationRate(q - 1 - res.min_interval_recovery_to_vaccine) // vdB(q - 1)
+                                                * age_data_vac2.GetOrigSusceptible(q - 1)                                        // * V2(q - 1)
+                            ;
+                        // 2c substracts early booster vaccinations from 2b
+                        else
+                            earlyBoos.at(q - 1) = age_data_boos.GetVaccinationRate(q - 1 - res.min_interval_doses) // vdB(q - 1)
+                                                * age_data_vac2.GetOrigSusceptible(q - 1)                          // * V2(q - 1)
+                            ;
+
+                        curr_vac2 -= earlyBoos.at(q - 1);
+                    }
+                    sanity_check(curr_vac2, __LINE__);
+                    age_data_vac2.SetSusceptible(q, curr_vac2);
+                }
+
+
+                if (reSusceptibility)
+                {
+                    double susc_from_rec_vac2 = age_data_vac2.GetOrigRecoveredBack()                                                                        // RV2(Tr)
+                                        * (1 - age_data_boos.GetVaccinationRate(age_data_vac2.GetRecoveredPhase() - res.min_interval_recovery_to_vaccine)); // * (1 - vdB(Tr))
+                    age_data_vac2.SetSusceptible(age_data_vac2.GetSusceptiblePhase(), susc_from_rec_vac2);
+                }
+                else
+                    age_data_vac2.KeepSusceptibleBack(); // V2(td2) doesn't move
+                
+                age_data_vac2.SetSusceptible(0, new_vac2); // Set the first day of the phase
+                sanity_check(age_data_vac2.GetTotalSusceptible(), __LINE__);
+            // </VACCINATED DOSE 2>
+            // <BOOSTER>
+            
+                // Calculate the number of new vaccinated booster, need to implement earlyBoos, 3a
+                double new_boos = new_vaccinatedB(datas, res, earlyBoos, force_of_infection, quiet);
+                sanity_check(new_boos, __LINE__);
+
+                // Moves everybody forward a day, VB(q - 1) is now on day q
+                age_data_boos.AdvanceSusceptible();
+
+                // qϵ{2...tdB - 1}
+                for (unsigned int q = age_data_boos.GetSusceptiblePhase()-1; q > 0; --q)
+                {
+                    // 3b
+                    curr_boos = age_data_boos.GetOrigSusceptible(q - 1); // VB(q - 1)
+
+                    if (!quiet)
+                    {
+                        age_data_boos.SetNewExposed(q, new_exposed(force_of_infection, age_data_boos, q - 1));
+                        curr_boos -= age_data_boos.GetNewExposed(q); // - VB(q - 1) * (1 - ivB(q - 1)) * sum( jϵ{1…k}(cij * kij * sum(bϵ{1...A} and nϵ{1...Ti}[...])) )
+                    }
+                    sanity_check(curr_boos, __LINE__);
+                    age_data_boos.SetSusceptible(q, curr_boos);
+                }           
+            
+            
+            // 3c
+            
+                double last_day_boos = age_data_boos.GetOrigSusceptible(age_data_boos.GetSusceptiblePhase() - 1) // VB(tdB - 1)
+                      + age_data_boos.GetOrigSusceptibleBack();                                        // VB(tdB)
+
+                if (!quiet)
+                {
+                    age_data_boos.SetNewExposed(age_data_boos.GetSusceptiblePhase() - 1, new_exposed(force_of_infection, age_data_boos, age_data_boos.GetSusceptiblePhase() - 1));
+                    age_data_boos.SetNewExposed(age_data_boos.GetSusceptiblePhase(), new_exposed(force_of_infection, age_data_boos, age_data_boos.GetSusceptiblePhase()));
+                    last_day_boos -= age_data_boos.GetNewExposed(age_data_boos.GetSusceptiblePhase() - 1); // - VB(tdB - 1) * (1 - iVB(tdB - 1)) * sum( jϵ{1...k}(cij * kij * sum(bϵ{1...A} and nϵ{1...Ti}[...]) )
+                    last_day_boos -= age_data_boos.GetNewExposed(age_data_boos.GetSusceptiblePhase());     // - VB(tdB) * (1 - iVB(tdB)) * sum( jϵ{1...k}(cij * kij * sum(bϵ{1...A} and nϵ{1...Ti}[...]) )
+                }
+
+                if (reSusceptibility)
+                  last_day_boos+= age_data_boos.GetOrigRecoveredBack(); // + RVB(Tr)
+
+                sanity_check(last_day_boos, __LINE__);
+                age_data_boos.SetSusceptible(age_data_boos.GetSusceptiblePhase(), last_day_boos); //Set last day of booster phase
+                age_data_boos.SetSusceptible(0, new_boos); // Set the first day of the phase
+                sanity_check(age_data_boos.GetTotalSusceptible(), __LINE__);
+            // </BOOSTER>
+        }
+
+        /**
+         * @brief Computes the exposed, infected, recovered, and dead equations for all population types
+         * Setup the the datas vector to hold all the population types and they'll be looped through
+         * 
+         * @param datas Vector of pointers holding the population states (i.e., NVac, Dose1, Dose2)
+         * @param res Current cell data
+         * @param force_of_infection Neighborhood sum computed by neighborhood_force_of_infection()
+         * @param quiet Is nobody exposed nor infected? Only the recovered phases are then computed (see next_state())
+         */
+        void compute_EIRD(vector<AgeData>& datas, sevirds& res, double force_of_infection, bool quiet) const
+        {
+            double new_expos, new_inf, new_rec;
+
+            for (AgeData& age_data : datas)
+            {
+
+                // The exposed and infected phases are all zeros, they only move forward a day
+                if (quiet)
+                {
+                    age_data.AdvanceExposed();
+                    age_data.SetExposed(0, 0.0);
+                    age_data.AdvanceInfected();
+                    age_data.SetInfected(0, 0.0);
+                    increment_recoveries(age_data);
+                    age_data.SetRecovered(0, 0.0);
+                    continue;
+                }
+
+                // <FATALITIES>
+                    // Calculates the new fatalities on each day of the infected phase
+                    // for easy use and less repetive code later
+                    age_data.SetTotalFatalities(new_fatalities(res, age_data));
+                    sanity_check(age_data.GetTotalFatalities(), __LINE__);
+                // </FATALITIES>
+
+                // <RECOVERIES>
+                    // Calculates the new recoveries on each day of the infected phase
+                    new_rec = new_recoveries(age_data);
+                // </RECOVERIES>
+
+                // <EXPOSED>
+                    new_expos = 0.0;
+
+                    // qϵ{1...Td2}
+                    for (unsigned int q = 0; q <= age_data.GetSusceptiblePhase(); ++q)
+                    {
+                        if (age_data.GetType() != AgeData::PopType::NVAC)
+                            new_expos += age_data.GetNewExposed(q);
+                        else
+                            new_expos += new_exposed(force_of_infection, age_data, q);
+                    }
+
+                    // Needs the exposed proportions before they are moved forward
+                    new_inf = new_infections(age_data);
+
+                    increment_exposed(age_data);
+
+                    age_data.SetExposed(0, new_expos);
+                // </EXPOSED>
+
+                // <INFECTED>
+                    increment_infections(age_data);
+
+                    age_data.SetInfected(0, new_inf);
+                // </INFECTED>
+
+                // <RECOVERED>
+                    increment_recoveries(age_data);
+
+                    // The people on the first day of recovery are those that were on the last stage of infection (minus those who died;
+                    // already accounted for) in the previous time step plus those that recovered early during an infection stage.
+                    age_data.SetRecovered(0, new_rec);
+                // </RECOVERED>
+            }
+        }
+
+        /**
+         * @brief Basic check that the proportion is not
+         * less then 0 or bigger then 1
+         * 
+         * @param value Proportion to check
+         * @param line  Line the function is called from (use __LINE__)
+         */
+        void sanity_check(double value, unsigned int line) const
+        {
+            // Can't be bigger then 1 or less then 0
+            if (value < (0 - one_over_prec_divider) || value > (1 + one_over_prec_divider))
+            {
+                value = round(value * prec_divider) * one_over_prec_divider;
+                    AssertLong(value >= 0 && value <= 1,
+                                __FILE__, line,
+                                to_string(value) + " is \033[33m" + (value < 0 ? "less then zero" : "bigger then one") + "\033[31m on day " + to_string((int)day));
+            }
+        }
+
+        /**
+         * @brief Moves the hysteresis of the cell on to the one of the day last computed by next_state(),
+         * once the simulator keeps the state of that day. Does nothing if that day didn't change the state
+         * or if it was already committed
+        */
+        void commit()
+        {
+            if (scratch.changed)
+                hysteresis.swap(scratch.hysteresis);
+            scratch.changed = false;
+        }
+
+        /**
+         * @brief Hysteresis of the movement restrictions of each neighbor, in the order of the neighborhood.
+         * Saved and restored along with the state of the cell by the checkpoints, a restored hysteresis
+         * isn't overwritten by a day computed before it
+        */
+        vector<hysteresis_factor>& hysteresis_factors()             { scratch.changed = false; return hysteresis; }
+        vector<hysteresis_factor> const& hysteresis_factors() const { return hysteresis; }
+
+    private:
+        // Day of the last next_state() call, only used by sanity_check()
+        mutable double day = 0;
+
+        // See hysteresis_factors(), it only changes through commit()
+        vector<hysteresis_factor> hysteresis;
+
+        // Reused by every next_state() call of the cell, see the class comment
+        struct scratch_arena
+        {
+            vector<AgeData> datas;            // Indexed by NVAC, VAC1, VAC2 then BOOS + booster index
+            vecDouble early_vac2, early_boos; // See compute_vaccinated()
+            infectious_pressure pressure;     // Summary of the last neighbor state asked for
+            vector<hysteresis_factor> hysteresis; // Hysteresis of the day last computed, until commit()
+            bool changed = false;             // Did the day last computed change the state? Until commit()
+        };
+
+        mutable scratch_arena scratch;
+}; //class geographical_equations{}
+
+#endif //PANDEMIC_HOYA_2002_GEOGRAPHICAL_EQUATIONS_HPP
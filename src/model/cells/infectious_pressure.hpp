@@ -0,0 +1,22 @@
+#ifndef PANDEMIC_HOYA_2002_INFECTIOUS_PRESSURE_HPP
+#define PANDEMIC_HOYA_2002_INFECTIOUS_PRESSURE_HPP
+
+#include <vector>
+
+using namespace std;
+
+/**
+ * Summary of the state of a cell holding only what its neighbors use to compute
+ * their force of infection. It's a few doubles per age group where the state
+ * holds every day of every phase.
+*/
+struct infectious_pressure
+{
+    double total_infections = 0.0; // Total infections of the cell
+    double disobedient      = 0.0; // Proportion of the population ignoring movement restrictions
+
+    vector<double> weighted_infections;   // Mobility and virulence weighted infections, by age group
+    vector<double> age_group_proportions; // Proportion of the population in each age group
+};
+
+#endif //PANDEMIC_HOYA_2002_INFECTIOUS_PRESSURE_HPP
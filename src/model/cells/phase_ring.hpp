@@ -0,0 +1,95 @@
+#ifndef PHASE_RING_HPP
+#define PHASE_RING_HPP
+
+#include <iostream>
+#include <numeric>
+#include <string>
+#include "../Helpers/Assert.hpp"
+
+using namespace std;
+
+/**
+ * Circular buffer view of the proportion of an age group on every day of a phase.
+ * The days live in the flat buffer of a sevirds object and the head in its list of heads.
+ * Day 0 is stored at the head, so moving everybody forward a day only moves the head
+ * back one slot: the old last day becomes day 0 and is then overwritten with the
+ * new arrivals of the phase.
+*/
+template <typename V, typename H>
+struct basic_phase_ring
+{
+    V* values;         // Physical storage of the days, use the day accessors below
+    unsigned int days; // Length of the phase
+    H* head;           // Physical index of the first day of the phase
+
+    basic_phase_ring(V* values, unsigned int days, H* head) : values{values}, days{days}, head{head} { }
+
+    // A writable view can always be read from
+    template <typename OV, typename OH>
+    basic_phase_ring(basic_phase_ring<OV, OH> const& other) : values{other.values}, days{other.days}, head{other.head} { }
+
+    unsigned int size() const { return days; }
+
+    V& at(unsigned int day) const { check(day);      return values[physical(day)];      }
+    V& front() const              { check(0);        return values[*head];              }
+    V& back() const               { check(days - 1); return values[physical(days - 1)]; }
+
+    /**
+     * @brief Moves every day of the phase forward by one.
+     * The value on the last day wraps around to day 0 and
+     * is expected to be overwritten by the caller
+    */
+    void advance() const { *head = (*head == 0) ? days - 1 : *head - 1; }
+
+    /**
+     * @brief Sums the phase from the first to the last day. The order is kept
+     * so the result is the same as it would be on a plain vector
+     *
+     * @return double
+    */
+    double sum() const
+    {
+        double total = accumulate(values + *head, values + days, 0.0);
+        return accumulate(values, values + *head, total);
+    }
+
+    template <typename OV, typename OH>
+    bool operator==(basic_phase_ring<OV, OH> const& other) const
+    {
+        if (days != other.days)
+            return false;
+
+        for (unsigned int day = 0; day < days; ++day)
+        {
+            if (at(day) != other.at(day))
+                return false;
+        }
+
+        return true;
+    }
+
+    template <typename OV, typename OH>
+    bool operator!=(basic_phase_ring<OV, OH> const& other) const { return !(*this == other); }
+
+    private:
+        // The phases used to be vectors read with .at(), so the equations' loops over the days are
+        // still bounds checked unless NDEBUG is defined. The message is only built when the check fails
+        void check(unsigned int day) const
+        {
+#ifndef NDEBUG
+            if (day >= days)
+                Assert::AssertLong(false, __FILE__, __LINE__, "Day " + to_string(day) + " is out of a phase of " + to_string(days) + " days");
+#endif
+        }
+
+        unsigned int physical(unsigned int day) const
+        {
+            day += *head;
+            return (day >= days) ? day - days : day;
+        }
+}; //struct basic_phase_ring{}
+
+using phase_ring       = basic_phase_ring<double, unsigned int>;
+using const_phase_ring = basic_phase_ring<double const, unsigned int const>;
+
+#endif // PHASE_RING_HPP
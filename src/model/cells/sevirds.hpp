@@ -4,49 +4,80 @@
 #ifndef PANDEMIC_HOYA_2002_SEIRD_HPP
 #define PANDEMIC_HOYA_2002_SEIRD_HPP
 
+#include <algorithm>
+#include <array>
 #include <iostream>
+#include <memory>
 #include <nlohmann/json.hpp>
-#include "hysteresis_factor.hpp"
+#include "phase_ring.hpp"
 #include "../Helpers/Assert.hpp"
+#include "../Helpers/chars_writer.hpp"
 
 using namespace std;
 using namespace Assert;
 
+/**
+ * Shape of the flat buffer of a sevirds object along with the parts
+ * of the state that never change during a simulation. It is shared by
+ * every copy of a cell's state so copying a state doesn't copy it.
+*/
+struct sevirds_layout
+{
+    using rateVector = vector<vector<double>>;
+
+    unsigned int num_age_groups       = 0;
+    unsigned int num_population_types = 0; // Non-vaccinated, dose 1, dose 2 then one per booster
+
+    // Indexed by [compartment * num_population_types + population type]
+    vector<unsigned int> days;    // Length of the phase
+    vector<unsigned int> offsets; // Where the phase of the first age group starts in the buffer
+
+    unsigned int fatalities_offset = 0;
+    unsigned int totals_offset     = 0; // Where the totals kept by sevirds::update_totals() start
+    unsigned int num_fields        = 0; // Number of values handed out by visit_fields()
+    unsigned int size              = 0;
+
+    vector<double> age_group_proportions;
+    vector<rateVector> immunity_rates; // Indexed by population type, empty for the non-vaccinated
+};
+
 /**
  * Keeps track of the model data and is initially
  * populated by what is store under the "state"
  * param found in default.json.
+ *
+ * Every phase of every compartment, population type and age group
+ * lives in one contiguous buffer followed by the fatalities and the totals of the state:
+ * { S: {NVac: {age1 days, age2 days...}, Dose1: {...}, Dose2: {...}, Booster1: {...}}, E: {...}, I: {...}, R: {...}, D, totals }
+ * The totals are part of the buffer so a copy of the state keeps them without allocating anything else.
 */
 struct sevirds
 {
     using proportionVector = vector<vector<double>>;    // { {doubles}, {doubles},   ......... }
                                                         //   ageGroup1  ageGroup2    ageGroup#
+    using rateVector       = sevirds_layout::rateVector;
 
-    double population;
-    vector<double> age_group_proportions;
-
-    // Susceptible
-    proportionVector susceptible;
-    proportionVector vaccinatedD1;
-    proportionVector vaccinatedD2;
+    enum compartment
+    {
+        SUSCEPTIBLE,
+        EXPOSED,
+        INFECTED,
+        RECOVERED,
+        NUM_COMPARTMENTS
+    };
 
-    // Exposed
-    proportionVector exposed;
-    proportionVector exposedD1;
-    proportionVector exposedD2;
+    // Population type indices used with phases()
+    static constexpr unsigned int NVAC_POP    = 0;
+    static constexpr unsigned int DOSE1_POP   = 1;
+    static constexpr unsigned int DOSE2_POP   = 2;
+    static constexpr unsigned int BOOSTER_POP = 3; // Booster i is BOOSTER_POP + i
 
-    // Infected
-    proportionVector infected;
-    proportionVector infectedD1;
-    proportionVector infectedD2;
+    double population;
 
-    // Recovered
-    proportionVector recovered;
-    proportionVector recoveredD1;
-    proportionVector recoveredD2;
-
-    // Fatalities
-    vector<double> fatalities;
+    shared_ptr<sevirds_layout const> layout;
+    vector<double> values;      // Every phase followed by the fatalities, see above
+    vector<unsigned int> heads; // Head of each phase ring, one per compartment, population type and age group
+    bool totals_valid = false; // Are the totals at the end of the buffer those of the phases? See update_totals()
 
     // Modifiers
     double disobedient;
@@ -54,19 +85,9 @@ struct sevirds
     double fatality_modifier;
 
     // Vaccines
-    proportionVector immunityD1_rate;
-    proportionVector immunityD2_rate;
     unsigned int min_interval_doses;
     unsigned int min_interval_recovery_to_vaccine;
 
-    // Boosters
-    vector<proportionVector> boosters;
-    vector<proportionVector> boosters_exposed;
-    vector<proportionVector> boosters_infected;
-    vector<proportionVector> boosters_recovered;
-    vector<proportionVector> boosters_immunity_rates;
-
-    unordered_map<string, hysteresis_factor> hysteresis_factors;
     unsigned int num_age_groups;
 
     bool vaccines;       // Are vaccines being modelled?
@@ -78,61 +99,111 @@ struct sevirds
     double one_over_prec_divider;
 
     // Required for the JSON library, as types used with it must be default-constructable.
-    // The overloaded constructor results in a default constructor having to be manually written.
     sevirds()
     {
+        num_age_groups        = 0;
         vaccines              = false;
         prec_divider          = 0;
         one_over_prec_divider = 0;
     };
 
-    sevirds(proportionVector sus, proportionVector vac1, proportionVector vac2,
-            proportionVector exp, proportionVector exp1, proportionVector exp2,
-            proportionVector inf, proportionVector inf1, proportionVector inf2,
-            proportionVector rec, proportionVector rec1, proportionVector rec2,
-            vector<double> fat, double dis, double hcap, double fatm, proportionVector immuD1, unsigned int min_interval,
-            proportionVector immuD2, double divider, bool vac=false) :
-                susceptible{move(sus)},
-                vaccinatedD1{move(vac1)},
-                vaccinatedD2{move(vac2)},
-                exposed{move(exp)},
-                exposedD1{move(exp1)},
-                exposedD2(move(exp2)),
-                infected{move(inf)},
-                infectedD1{move(inf1)},
-                infectedD2{move(inf2)},
-                recovered{move(rec)},
-                recoveredD1{move(rec1)},
-                recoveredD2{move(rec2)},
-                fatalities{move(fat)},
-                disobedient{dis},
-                hospital_capacity{hcap},
-                fatality_modifier{fatm},
-                immunityD1_rate{move(immuD1)},
-                immunityD2_rate{move(immuD2)},
-                min_interval_doses{min_interval},
-                vaccines(vac),
-                prec_divider(divider),
-                one_over_prec_divider(1.0 / divider)
-    { num_age_groups = age_group_proportions.size(); }
+    /**
+     * @brief Phase of one age group of a population type
+     * 
+     * @param comp Compartment of the phase
+     * @param pop_type NVAC_POP, DOSE1_POP, DOSE2_POP or BOOSTER_POP + booster index
+     * @param age_group Age group of the phase
+     * @return phase_ring
+    */
+    phase_ring phases(compartment comp, unsigned int pop_type, unsigned int age_group)
+    {
+        totals_valid = false;
+
+        unsigned int block = comp * layout->num_population_types + pop_type;
+        unsigned int days  = layout->days[block];
+
+        return phase_ring(values.data() + layout->offsets[block] + age_group * days, days,
+                            heads.data() + block * num_age_groups + age_group);
+    }
+
+    const_phase_ring phases(compartment comp, unsigned int pop_type, unsigned int age_group) const
+    {
+        unsigned int block = comp * layout->num_population_types + pop_type;
+        unsigned int days  = layout->days[block];
+
+        return const_phase_ring(values.data() + layout->offsets[block] + age_group * days, days,
+                                heads.data() + block * num_age_groups + age_group);
+    }
+
+    // Susceptible
+    phase_ring susceptible(unsigned int age)                          { return phases(SUSCEPTIBLE, NVAC_POP,  age);            }
+    phase_ring vaccinatedD1(unsigned int age)                         { return phases(SUSCEPTIBLE, DOSE1_POP, age);            }
+    phase_ring vaccinatedD2(unsigned int age)                         { return phases(SUSCEPTIBLE, DOSE2_POP, age);            }
+    phase_ring boosters(unsigned int booster, unsigned int age)       { return phases(SUSCEPTIBLE, BOOSTER_POP + booster, age); }
+    const_phase_ring susceptible(unsigned int age) const                    { return phases(SUSCEPTIBLE, NVAC_POP,  age);            }
+    const_phase_ring vaccinatedD1(unsigned int age) const                   { return phases(SUSCEPTIBLE, DOSE1_POP, age);            }
+    const_phase_ring vaccinatedD2(unsigned int age) const                   { return phases(SUSCEPTIBLE, DOSE2_POP, age);            }
+    const_phase_ring boosters(unsigned int booster, unsigned int age) const { return phases(SUSCEPTIBLE, BOOSTER_POP + booster, age); }
+
+    // Exposed
+    phase_ring exposed(unsigned int age)                                  { return phases(EXPOSED, NVAC_POP,  age);            }
+    phase_ring exposedD1(unsigned int age)                                { return phases(EXPOSED, DOSE1_POP, age);            }
+    phase_ring exposedD2(unsigned int age)                                { return phases(EXPOSED, DOSE2_POP, age);            }
+    phase_ring boosters_exposed(unsigned int booster, unsigned int age)   { return phases(EXPOSED, BOOSTER_POP + booster, age); }
+    const_phase_ring exposed(unsigned int age) const                                { return phases(EXPOSED, NVAC_POP,  age);            }
+    const_phase_ring exposedD1(unsigned int age) const                              { return phases(EXPOSED, DOSE1_POP, age);            }
+    const_phase_ring exposedD2(unsigned int age) const                              { return phases(EXPOSED, DOSE2_POP, age);            }
+    const_phase_ring boosters_exposed(unsigned int booster, unsigned int age) const { return phases(EXPOSED, BOOSTER_POP + booster, age); }
+
+    // Infected
+    phase_ring infected(unsigned int age)                                 { return phases(INFECTED, NVAC_POP,  age);            }
+    phase_ring infectedD1(unsigned int age)                               { return phases(INFECTED, DOSE1_POP, age);            }
+    phase_ring infectedD2(unsigned int age)                               { return phases(INFECTED, DOSE2_POP, age);            }
+    phase_ring boosters_infected(unsigned int booster, unsigned int age)  { return phases(INFECTED, BOOSTER_POP + booster, age); }
+    const_phase_ring infected(unsigned int age) const                                { return phases(INFECTED, NVAC_POP,  age);            }
+    const_phase_ring infectedD1(unsigned int age) const                              { return phases(INFECTED, DOSE1_POP, age);            }
+    const_phase_ring infectedD2(unsigned int age) const                              { return phases(INFECTED, DOSE2_POP, age);            }
+    const_phase_ring boosters_infected(unsigned int booster, unsigned int age) const { return phases(INFECTED, BOOSTER_POP + booster, age); }
+
+    // Recovered
+    phase_ring recovered(unsigned int age)                                { return phases(RECOVERED, NVAC_POP,  age);            }
+    phase_ring recoveredD1(unsigned int age)                              { return phases(RECOVERED, DOSE1_POP, age);            }
+    phase_ring recoveredD2(unsigned int age)                              { return phases(RECOVERED, DOSE2_POP, age);            }
+    phase_ring boosters_recovered(unsigned int booster, unsigned int age) { return phases(RECOVERED, BOOSTER_POP + booster, age); }
+    const_phase_ring recovered(unsigned int age) const                                { return phases(RECOVERED, NVAC_POP,  age);            }
+    const_phase_ring recoveredD1(unsigned int age) const                              { return phases(RECOVERED, DOSE1_POP, age);            }
+    const_phase_ring recoveredD2(unsigned int age) const                              { return phases(RECOVERED, DOSE2_POP, age);            }
+    const_phase_ring boosters_recovered(unsigned int booster, unsigned int age) const { return phases(RECOVERED, BOOSTER_POP + booster, age); }
+
+    // Fatalities
+    double& fatalities(unsigned int age)             { totals_valid = false; return values.at(layout->fatalities_offset + age); }
+    double const& fatalities(unsigned int age) const { return values.at(layout->fatalities_offset + age); }
+
+    // Tables that never change
+    vector<double> const& age_group_proportions() const                          { return layout->age_group_proportions;                                 }
+    vector<double> const& immunityD1_rate(unsigned int age) const                { return layout->immunity_rates.at(DOSE1_POP).at(age);                  }
+    vector<double> const& immunityD2_rate(unsigned int age) const                { return layout->immunity_rates.at(DOSE2_POP).at(age);                  }
+    vector<double> const& boosters_immunity_rates(unsigned int booster, unsigned int age) const { return layout->immunity_rates.at(BOOSTER_POP + booster).at(age); }
 
     // GETTERS
-    unsigned int get_num_age_segments() const       { return num_age_groups;                }
-    unsigned int get_num_exposed_phases() const     { return exposed.front().size();        }
-    unsigned int get_num_infected_phases() const    { return infected.front().size();       }
-    unsigned int get_num_recovered_phases() const   { return recovered.front().size();      }
-    unsigned int get_num_vaccinated1_phases() const { return vaccinatedD1.front().size();   }
-    unsigned int get_num_vaccinated2_phases() const { return vaccinatedD2.front().size();   }
-    unsigned int get_immunity1_num_weeks() const    { return immunityD1_rate.size();        }
-    unsigned int get_immunity2_num_weeks() const    { return immunityD2_rate.size();        }
+    unsigned int get_num_age_segments() const       { return num_age_groups;                                          }
+    unsigned int get_num_boosters() const           { return num_boosters();                                          }
+    unsigned int num_boosters() const               { return layout ? layout->num_population_types - BOOSTER_POP : 0; }
+    unsigned int get_num_exposed_phases() const     { return layout->days.at(EXPOSED     * layout->num_population_types); }
+    unsigned int get_num_infected_phases() const    { return layout->days.at(INFECTED    * layout->num_population_types); }
+    unsigned int get_num_recovered_phases() const   { return layout->days.at(RECOVERED   * layout->num_population_types); }
+    unsigned int get_num_vaccinated1_phases() const { return layout->days.at(SUSCEPTIBLE * layout->num_population_types + DOSE1_POP); }
+    unsigned int get_num_vaccinated2_phases() const { return layout->days.at(SUSCEPTIBLE * layout->num_population_types + DOSE2_POP); }
+    unsigned int get_immunity1_num_weeks() const    { return layout->immunity_rates.at(DOSE1_POP).size(); }
+    unsigned int get_immunity2_num_weeks() const    { return layout->immunity_rates.at(DOSE2_POP).size(); }
 
     /**
-     * @brief Sums all the values in a vector
+     * @brief Sums all the days in a phase
      * 
-     * @param state_vector Vector to be summed
+     * @param state_vector Phase to be summed
      * @return double
     */
-    static double sum_state_vector(const vector<double>& state_vector) { return accumulate(state_vector.begin(), state_vector.end(), 0.0); }
+    static double sum_state_vector(const_phase_ring state_vector) { return state_vector.sum(); }
 
     /**
      * @brief Get the total susceptible population count. This includes those who are
@@ -151,30 +222,30 @@ struct sevirds
             for (unsigned int i = 0; i < num_age_groups; ++i)
             {
                 // Total non-vaccinated
-                total_susceptible += susceptible.at(i).front() * age_group_proportions.at(i);
+                total_susceptible += susceptible(i).front() * age_group_proportions().at(i);
 
                 // Total vaccianted (Dose1 + Dose2)
                 if (vaccines && !getNVac)
                 {
-                    total_susceptible += sum_state_vector(vaccinatedD1.at(i)) * age_group_proportions.at(i);
-                    total_susceptible += sum_state_vector(vaccinatedD2.at(i)) * age_group_proportions.at(i);
+                    total_susceptible += sum_state_vector(vaccinatedD1(i)) * age_group_proportions().at(i);
+                    total_susceptible += sum_state_vector(vaccinatedD2(i)) * age_group_proportions().at(i);
 
-                    for (unsigned int j = 0; j < boosters.size(); ++j)
-                        total_susceptible += sum_state_vector(boosters.at(j).at(i)) * age_group_proportions.at(i);
+                    for (unsigned int j = 0; j < num_boosters(); ++j)
+                        total_susceptible += sum_state_vector(boosters(j, i)) * age_group_proportions().at(i);
                 }
             }
         }
         else
         {
-            total_susceptible = susceptible.at(age_group).front();
+            total_susceptible = susceptible(age_group).front();
 
             if (vaccines)
             {
-                total_susceptible += sum_state_vector(vaccinatedD1.at(age_group));
-                total_susceptible += sum_state_vector(vaccinatedD2.at(age_group));
+                total_susceptible += sum_state_vector(vaccinatedD1(age_group));
+                total_susceptible += sum_state_vector(vaccinatedD2(age_group));
 
-                for (unsigned int i = 0; i < boosters.size(); ++i)
-                    total_susceptible += sum_state_vector(boosters.at(i).at(age_group)) * age_group_proportions.at(age_group);
+                for (unsigned int i = 0; i < num_boosters(); ++i)
+                    total_susceptible += sum_state_vector(boosters(i, age_group)) * age_group_proportions().at(age_group);
             }
         }
 
@@ -196,11 +267,11 @@ struct sevirds
             for (unsigned int i = 0; i < num_age_groups; ++i)
             {
                 // Total vaccinated Dose 1
-                total_vaccinatedD1 += sum_state_vector(vaccinatedD1.at(i)) * age_group_proportions.at(i);
+                total_vaccinatedD1 += sum_state_vector(vaccinatedD1(i)) * age_group_proportions().at(i);
             }
         }
         else
-            total_vaccinatedD1 = sum_state_vector(vaccinatedD1.at(age_group));
+            total_vaccinatedD1 = sum_state_vector(vaccinatedD1(age_group));
 
         return total_vaccinatedD1;
     }
@@ -220,11 +291,11 @@ struct sevirds
             for (unsigned int i = 0; i < num_age_groups; ++i)
             {
                 // Total vaccinated Dose 2
-                total_vaccinatedD2 += sum_state_vector(vaccinatedD2.at(i)) * age_group_proportions.at(i);
+                total_vaccinatedD2 += sum_state_vector(vaccinatedD2(i)) * age_group_proportions().at(i);
             }
         }
         else
-            total_vaccinatedD2 = sum_state_vector(vaccinatedD2.at(age_group));
+            total_vaccinatedD2 = sum_state_vector(vaccinatedD2(age_group));
 
         return total_vaccinatedD2;
     }
@@ -236,10 +307,10 @@ struct sevirds
         if (age_group == -1)
         {
             for (unsigned int i = 0; i < num_age_groups; ++i)
-                total_boosted += sum_state_vector(boosters.at(booster_num).at(i)) * age_group_proportions.at(i);
+                total_boosted += sum_state_vector(boosters(booster_num, i)) * age_group_proportions().at(i);
         }
         else
-            total_boosted = sum_state_vector(boosters.at(booster_num).at(age_group)) * age_group_proportions.at(age_group);
+            total_boosted = sum_state_vector(boosters(booster_num, age_group)) * age_group_proportions().at(age_group);
         return  total_boosted;
     }
 
@@ -258,36 +329,49 @@ struct sevirds
             for (unsigned int i = 0; i < num_age_groups; ++i)
             {
                 // Total non-vaccinated exposed
-                total_exposed += sum_state_vector(exposed.at(i)) * age_group_proportions.at(i);
+                total_exposed += sum_state_vector(exposed(i)) * age_group_proportions().at(i);
 
                 // Total vaccinated exposed (Dose1 + Dose2)
                 if (vaccines)
                 {
-                    total_exposed += sum_state_vector(exposedD1.at(i)) * age_group_proportions.at(i);
-                    total_exposed += sum_state_vector(exposedD2.at(i)) * age_group_proportions.at(i);
+                    total_exposed += sum_state_vector(exposedD1(i)) * age_group_proportions().at(i);
+                    total_exposed += sum_state_vector(exposedD2(i)) * age_group_proportions().at(i);
 
-                    for (unsigned int j = 0; j < boosters_exposed.size(); ++j)
-                        total_exposed += sum_state_vector(boosters_exposed.at(j).at(i)) * age_group_proportions.at(i);
+                    for (unsigned int j = 0; j < num_boosters(); ++j)
+                        total_exposed += sum_state_vector(boosters_exposed(j, i)) * age_group_proportions().at(i);
                 }
             }
         }
         else
         {
-            total_exposed += sum_state_vector(exposed.at(age_group));
+            total_exposed += sum_state_vector(exposed(age_group));
 
             if (vaccines)
             {
-                total_exposed += sum_state_vector(exposedD1.at(age_group));
-                total_exposed += sum_state_vector(exposedD2.at(age_group));
+                total_exposed += sum_state_vector(exposedD1(age_group));
+                total_exposed += sum_state_vector(exposedD2(age_group));
 
-                for (unsigned int j = 0; j < boosters_exposed.size(); ++j)
-                    total_exposed += sum_state_vector(boosters_exposed.at(j).at(age_group)) * age_group_proportions.at(age_group);
+                for (unsigned int j = 0; j < num_boosters(); ++j)
+                    total_exposed += sum_state_vector(boosters_exposed(j, age_group)) * age_group_proportions().at(age_group);
             }
         }
 
         return total_exposed;
     }
 
+    /**
+     * @brief Whether nobody is exposed or infected, whatever their age group and population type.
+     * The exposed and infected phases follow each other in the buffer so they're checked in one pass
+     *
+     * @return bool
+     */
+    bool is_free_of_infection() const
+    {
+        double const* first = values.data() + layout->offsets[EXPOSED * layout->num_population_types];
+        double const* last  = values.data() + layout->offsets[RECOVERED * layout->num_population_types];
+        return all_of(first, last, [](double value) { return value == 0; });
+    }
+
     /**
      * @brief Returns the total infected population inlcuding those who are vaccinated
      * 
@@ -303,28 +387,28 @@ struct sevirds
             for (unsigned int i = 0; i < num_age_groups; ++i)
             {
                 // Total non-vaccinated infected
-                total_infections += sum_state_vector(infected.at(i)) * age_group_proportions.at(i);
+                total_infections += sum_state_vector(infected(i)) * age_group_proportions().at(i);
 
                 // Total vaccinated infected (Dose1 + Dose2)
                 if (vaccines)
                 {
-                    total_infections += sum_state_vector(infectedD1.at(i)) * age_group_proportions.at(i);
-                    total_infections += sum_state_vector(infectedD2.at(i)) * age_group_proportions.at(i);
-                    for (unsigned int j = 0; j < boosters_infected.size(); ++j)
-                        total_infections += sum_state_vector(boosters_infected.at(j).at(i)) * age_group_proportions.at(i);
+                    total_infections += sum_state_vector(infectedD1(i)) * age_group_proportions().at(i);
+                    total_infections += sum_state_vector(infectedD2(i)) * age_group_proportions().at(i);
+                    for (unsigned int j = 0; j < num_boosters(); ++j)
+                        total_infections += sum_state_vector(boosters_infected(j, i)) * age_group_proportions().at(i);
                 }
             }
         }
         else
         {
-            total_infections += sum_state_vector(infected.at(age_group));
+            total_infections += sum_state_vector(infected(age_group));
 
             if (vaccines)
             {
-                total_infections += sum_state_vector(infectedD1.at(age_group));
-                total_infections += sum_state_vector(infectedD2.at(age_group));
-                for (unsigned int j = 0; j < boosters_infected.size(); ++j)
-                    total_infections += sum_state_vector(boosters_infected.at(j).at(age_group)) * age_group_proportions.at(age_group);
+                total_infections += sum_state_vector(infectedD1(age_group));
+                total_infections += sum_state_vector(infectedD2(age_group));
+                for (unsigned int j = 0; j < num_boosters(); ++j)
+                    total_infections += sum_state_vector(boosters_infected(j, age_group)) * age_group_proportions().at(age_group);
             }
         }
 
@@ -347,28 +431,28 @@ struct sevirds
             for(unsigned int i = 0; i < num_age_groups; ++i)
             {
                 // Total non-vaccinated recoveries
-                total_recoveries += sum_state_vector(recovered.at(i)) * age_group_proportions.at(i);
+                total_recoveries += sum_state_vector(recovered(i)) * age_group_proportions().at(i);
 
                 // Total vaccinated recoveries (Dose1 + Dose2)
                 if (vaccines)
                 {
-                    total_recoveries += sum_state_vector(recoveredD1.at(i)) * age_group_proportions.at(i);
-                    total_recoveries += sum_state_vector(recoveredD2.at(i)) * age_group_proportions.at(i);
-                    for (unsigned int j = 0; j < boosters_recovered.size(); ++j)
-                        total_recoveries += sum_state_vector(boosters_recovered.at(j).at(i)) * age_group_proportions.at(i);
+                    total_recoveries += sum_state_vector(recoveredD1(i)) * age_group_proportions().at(i);
+                    total_recoveries += sum_state_vector(recoveredD2(i)) * age_group_proportions().at(i);
+                    for (unsigned int j = 0; j < num_boosters(); ++j)
+                        total_recoveries += sum_state_vector(boosters_recovered(j, i)) * age_group_proportions().at(i);
                 }
             }
         }
         else
         {
-            total_recoveries += sum_state_vector(recovered.at(age_group));
+            total_recoveries += sum_state_vector(recovered(age_group));
 
             if (vaccines)
             {
-                total_recoveries += sum_state_vector(recoveredD1.at(age_group));
-                total_recoveries += sum_state_vector(recoveredD2.at(age_group));
-                for (unsigned int j = 0; j < boosters_recovered.size(); ++j)
-                    total_recoveries += sum_state_vector(boosters_recovered.at(j).at(age_group)) * age_group_proportions.at(age_group);
+                total_recoveries += sum_state_vector(recoveredD1(age_group));
+                total_recoveries += sum_state_vector(recoveredD2(age_group));
+                for (unsigned int j = 0; j < num_boosters(); ++j)
+                    total_recoveries += sum_state_vector(boosters_recovered(j, age_group)) * age_group_proportions().at(age_group);
             }
         }
 
@@ -385,18 +469,42 @@ struct sevirds
         double total_fatalities = 0.0f;
 
         for (unsigned int i = 0; i < num_age_groups; ++i)
-            total_fatalities += fatalities.at(i) * age_group_proportions.at(i);
+            total_fatalities += fatalities(i) * age_group_proportions().at(i);
 
         return total_fatalities;
     }
 
+    /**
+     * @brief Only the non-vaccinated, dose 1 and dose 2 phases
+     * and the fatalities decide if the state has changed
+     * 
+     * @param other State to compare against
+     * @return bool
+    */
     bool operator!=(const sevirds& other) const
     {
-        return  (susceptible != other.susceptible) || (vaccinatedD1 != other.vaccinatedD1) || (vaccinatedD2 != other.vaccinatedD2) ||
-                (exposed != other.exposed) || (exposedD1 != other.exposedD1) || (exposedD2 != other.exposedD2) ||
-                (infected != other.infected) || (infectedD1 != other.infectedD1) || (infectedD2 != other.infectedD2) ||
-                (recovered != other.recovered) || (recoveredD1 != other.recoveredD1) || (recoveredD2 != other.recoveredD2) ||
-                (fatalities != other.fatalities);
+        if (values.size() != other.values.size())
+            return true;
+
+        for (unsigned int comp = SUSCEPTIBLE; comp < NUM_COMPARTMENTS; ++comp)
+        {
+            for (unsigned int pop = NVAC_POP; pop < BOOSTER_POP; ++pop)
+            {
+                for (unsigned int age = 0; age < num_age_groups; ++age)
+                {
+                    if (phases((compartment)comp, pop, age) != other.phases((compartment)comp, pop, age))
+                        return true;
+                }
+            }
+        }
+
+        for (unsigned int age = 0; age < num_age_groups; ++age)
+        {
+            if (fatalities(age) != other.fatalities(age))
+                return true;
+        }
+
+        return false;
     }
 
     /**
@@ -406,8 +514,142 @@ struct sevirds
      * @return double
      */
     double precision_divider(double proportion) const { return round(proportion * prec_divider) * one_over_prec_divider; }
+
+    /**
+     * @brief Computes the totals of the state kept at the end of its buffer: the values handed out by
+     * visit_fields(), then the total exposed and infected proportions as get_total_exposed() and
+     * get_total_infections() give them. Called once a state is final, when it is loaded or computed,
+     * so the logs, the neighbors and the monitors all read the same totals without walking the phases again
+     */
+    void update_totals()
+    {
+        sevirds const& state = *this; // Only reads the phases, the non-const accessors would drop the totals
+        double* totals       = values.data() + layout->totals_offset;
+        unsigned int f       = 0;
+
+        double new_exposed    = 0;
+        double new_infections = 0;
+        double new_recoveries = 0;
+
+        double total_susceptible  = 0; // Non-vaccinated only
+        double total_exposed      = 0;
+        double total_infected     = 0;
+        double total_recovered    = 0;
+        double total_fatalities   = 0;
+        double total_vaccinatedD1 = 0;
+        double total_vaccinatedD2 = 0;
+
+        double age_group_proportion;
+
+        // Every phase is only walked once. Each total is still summed in the same order as
+        // its get_total_*() function so the values are exactly the same
+        for (unsigned int i = 0; i < num_age_groups; ++i)
+        {
+            // Get the age group
+            age_group_proportion = age_group_proportions().at(i);
+
+            // Non-Vaccinated
+            new_exposed    += state.exposed(i).front()   * age_group_proportion; // Exposed
+            new_infections += state.infected(i).front()  * age_group_proportion; // Infected
+            new_recoveries += state.recovered(i).front() * age_group_proportion; // Recovered
+
+            total_susceptible += state.susceptible(i).front() * age_group_proportion;
+            total_exposed     += state.exposed(i).sum()       * age_group_proportion;
+            total_infected    += state.infected(i).sum()      * age_group_proportion;
+            total_recovered   += state.recovered(i).sum()     * age_group_proportion;
+            total_fatalities  += state.fatalities(i)          * age_group_proportion;
+
+            // Vaccinated
+            if (vaccines)
+            {
+                // Dose 1
+                new_exposed    += state.exposedD1(i).front()   * age_group_proportion;
+                new_infections += state.infectedD1(i).front()  * age_group_proportion;
+                new_recoveries += state.recoveredD1(i).front() * age_group_proportion;
+
+                // Dose 2
+                new_exposed    += state.exposedD2(i).front()   * age_group_proportion;
+                new_infections += state.infectedD2(i).front()  * age_group_proportion;
+                new_recoveries += state.recoveredD2(i).front() * age_group_proportion;
+
+                total_vaccinatedD1 += state.vaccinatedD1(i).sum() * age_group_proportion;
+                total_vaccinatedD2 += state.vaccinatedD2(i).sum() * age_group_proportion;
+
+                total_exposed   += state.exposedD1(i).sum()   * age_group_proportion;
+                total_exposed   += state.exposedD2(i).sum()   * age_group_proportion;
+                total_infected  += state.infectedD1(i).sum()  * age_group_proportion;
+                total_infected  += state.infectedD2(i).sum()  * age_group_proportion;
+                total_recovered += state.recoveredD1(i).sum() * age_group_proportion;
+                total_recovered += state.recoveredD2(i).sum() * age_group_proportion;
+
+                for (unsigned int j = 0; j < num_boosters(); ++j)
+                {
+                    total_exposed   += state.boosters_exposed(j, i).sum()   * age_group_proportion;
+                    total_infected  += state.boosters_infected(j, i).sum()  * age_group_proportion;
+                    total_recovered += state.boosters_recovered(j, i).sum() * age_group_proportion;
+                }
+            }
+        }
+
+        totals[f++] = population;
+        totals[f++] = precision_divider(total_susceptible);
+        totals[f++] = precision_divider(total_exposed);
+        totals[f++] = vaccines ? precision_divider(total_vaccinatedD1) : 0.0;
+        totals[f++] = vaccines ? precision_divider(total_vaccinatedD2) : 0.0;
+        totals[f++] = precision_divider(total_infected);
+        totals[f++] = precision_divider(total_recovered);
+        totals[f++] = precision_divider(new_exposed);
+        totals[f++] = precision_divider(new_infections);
+        totals[f++] = precision_divider(new_recoveries);
+        totals[f++] = precision_divider(total_fatalities);
+
+        // The susceptible boosted are the only phases not walked above
+        for (unsigned int j = 0; j < num_boosters(); ++j)
+        {
+            double total_boosted = 0;
+            for (unsigned int i = 0; i < num_age_groups; ++i)
+                total_boosted += state.boosters(j, i).sum() * age_group_proportions().at(i);
+
+            totals[f++] = precision_divider(total_boosted);
+        }
+
+        totals[f++] = total_exposed;
+        totals[f++] = total_infected;
+        totals_valid = true;
+    }
+
+    /**
+     * @brief Totals computed by update_totals(). Whatever makes a state calls it once the state is complete:
+     * the equations for the initial and the next states, a checkpoint or a branch for the states they change
+     *
+     * @return double const* The values of visit_fields() followed by the total exposed and infected proportions
+     */
+    double const* totals() const
+    {
+        AssertLong(totals_valid, __FILE__, __LINE__, "The totals of a state are read before update_totals() was called since it changed");
+        return values.data() + layout->totals_offset;
+    }
+
+    double total_exposed() const    { return totals()[layout->num_fields];     }
+    double total_infections() const { return totals()[layout->num_fields + 1]; }
 }; //struct servids{}
 
+/**
+ * @brief Hands out the values logged for a state, in the order they are output:
+ * population, S, E, VD1, VD2, I, R, new E, new I, new R, D then one per booster.
+ * They are the totals kept by the state, see sevirds::update_totals()
+ *
+ * @param sevirds Current simulation data
+ * @param field Called with each value
+ */
+template <typename FIELD>
+void visit_fields(const sevirds& sevirds, FIELD&& field)
+{
+    double const* totals = sevirds.totals();
+    for (unsigned int f = 0; f < sevirds.layout->num_fields; ++f)
+        field(totals[f]);
+}
+
 /**
  * @brief Outputs <population, S, E, VD1, VD2, I, R, new E, new I, new R, D>
  * 
@@ -417,78 +659,30 @@ struct sevirds
  */
 ostream &operator<<(ostream& os, const sevirds& sevirds)
 {
-    double new_exposed    = 0;
-    double new_infections = 0;
-    double new_recoveries = 0;
-
-    double age_group_proportion;
+    char separator = '<';
 
-    // Calculate the new exposures, infectsions and recoveries
-    // on the first day of each respective phase
-    for (unsigned int i = 0; i < sevirds.num_age_groups; ++i)
+    // Write the digits straight into a buffer unless the stream would format them differently
+    if (chars_writer::formats_like(os))
     {
-        // Get the age group
-        age_group_proportion = sevirds.age_group_proportions.at(i);
-
-        // Non-Vaccinated
-        new_exposed    += sevirds.exposed.at(i).front()   * age_group_proportion; // Exposed
-        new_infections += sevirds.infected.at(i).front()  * age_group_proportion; // Infected
-        new_recoveries += sevirds.recovered.at(i).front() * age_group_proportion; // Recovered
+        chars_writer out(os);
+        int precision = os.precision();
 
-        // Vaccinated
-        if (sevirds.vaccines)
-        {
-            // Dose 1
-            new_exposed    += sevirds.exposedD1.at(i).front()   * age_group_proportion;
-            new_infections += sevirds.infectedD1.at(i).front()  * age_group_proportion;
-            new_recoveries += sevirds.recoveredD1.at(i).front() * age_group_proportion;
-
-            // Dose 2
-            new_exposed    += sevirds.exposedD2.at(i).front()   * age_group_proportion;
-            new_infections += sevirds.infectedD2.at(i).front()  * age_group_proportion;
-            new_recoveries += sevirds.recoveredD2.at(i).front() * age_group_proportion;
-        }
-    }
+        visit_fields(sevirds, [&](double value) {
+            out.put(separator);
+            out.put(value, precision);
+            separator = ',';
+        });
 
-    // Precision corrrection
-    new_exposed    = sevirds.precision_divider(new_exposed);
-    new_infections = sevirds.precision_divider(new_infections);
-    new_recoveries = sevirds.precision_divider(new_recoveries);
-
-    // Calculate the totals from each day in every phase
-    double total_susceptible = sevirds.precision_divider(sevirds.get_total_susceptible(true));
-    double total_exposed     = sevirds.precision_divider(sevirds.get_total_exposed());
-    double total_infected    = sevirds.precision_divider(sevirds.get_total_infections());
-    double total_recovered   = sevirds.precision_divider(sevirds.get_total_recovered());
-    double total_fatalities  = sevirds.precision_divider(sevirds.get_total_fatalities());
-
-    // Susceptible Vaccinated
-    double total_vaccinatedD1 = 0.0, total_vaccinatedD2 = 0.0;
-    if (sevirds.vaccines)
-    {
-        total_vaccinatedD1 = sevirds.precision_divider(sevirds.get_total_vaccinatedD1());
-        total_vaccinatedD2 = sevirds.precision_divider(sevirds.get_total_vaccinatedD2());
+        out.put('>');
+        return os;
     }
 
     // Pipe all the data
-    os << "<" <<sevirds.population<< "," << total_susceptible << "," << total_exposed << "," << total_vaccinatedD1
-        << "," << total_vaccinatedD2 << "," << total_infected << "," << total_recovered << "," << new_exposed
-        << "," << new_infections << "," << new_recoveries << "," << total_fatalities; 
-
-    if (sevirds.boosters.size() != 0)
-    {
-        os << ",";
-
-        double total_boosted;
-        for (unsigned int i = 0; i < sevirds.boosters.size(); ++i)
-        {
-            total_boosted = sevirds.precision_divider(sevirds.get_total_boosted(i));
-            os << total_boosted;
+    visit_fields(sevirds, [&](double value) {
+        os << separator << value;
+        separator = ',';
+    });
 
-            if (i + 1 < sevirds.boosters.size())
-                os << ",";
-        }
-    }
     os << ">";
     return os;
 }
@@ -502,93 +696,151 @@ ostream &operator<<(ostream& os, const sevirds& sevirds)
 void from_json(const nlohmann::json& json, sevirds& current_sevirds)
 {
     json.at("population").get_to(current_sevirds.population);
-    json.at("age_group_proportions").get_to(current_sevirds.age_group_proportions);
 
-    try { json.at("susceptible").get_to(current_sevirds.susceptible); }
-    catch(nlohmann::detail::type_error &e) { AssertLong(false, __FILE__, __LINE__, "Error reading the susceptible vector from either default.json OR infectedCell.json\nVerify the format is [[#], [#], ...] and NOT [#, #, ...]"); }
+    shared_ptr<sevirds_layout> layout = make_shared<sevirds_layout>();
+    json.at("age_group_proportions").get_to(layout->age_group_proportions);
+
+    // Names of the phases of each population type, in the order of sevirds::compartment
+    vector<array<string, sevirds::NUM_COMPARTMENTS>> phase_names = {
+        {"susceptible",  "exposed",   "infected",   "recovered"},
+        {"vaccinatedD1", "exposedD1", "infectedD1", "recoveredD1"},
+        {"vaccinatedD2", "exposedD2", "infectedD2", "recoveredD2"}
+    };
+    vector<string> immunity_names = {"", "immunityD1", "immunityD2"};
+
+    for (unsigned int i = 1; json.contains("booster" + to_string(i)); ++i)
+    {
+        string booster = to_string(i);
+        phase_names.push_back({"booster" + booster, "exposedB" + booster, "infectedB" + booster, "recoveredB" + booster});
+        immunity_names.push_back("immunityB" + booster);
+
+        AssertLong(json.contains("exposedB" + booster) && json.contains("infectedB" + booster) && json.contains("recoveredB" + booster) && json.contains("immunityB" + booster),
+                    __FILE__, __LINE__, "Need matching exposed, infected, recovered, and immunity lists for booster" + booster);
+    }
 
-    json.at("vaccinatedD1").get_to(current_sevirds.vaccinatedD1);
-    json.at("vaccinatedD2").get_to(current_sevirds.vaccinatedD2);
+    unsigned int num_population_types = phase_names.size();
 
-    json.at("exposed").get_to(current_sevirds.exposed);
-    json.at("exposedD1").get_to(current_sevirds.exposedD1);
-    json.at("exposedD2").get_to(current_sevirds.exposedD2);
+    // Every phase as it's written in the json [population type][compartment]
+    vector<array<sevirds::proportionVector, sevirds::NUM_COMPARTMENTS>> phases(num_population_types);
 
-    json.at("infected").get_to(current_sevirds.infected);
-    json.at("infectedD1").get_to(current_sevirds.infectedD1);
-    json.at("infectedD2").get_to(current_sevirds.infectedD2);
+    try { json.at("susceptible").get_to(phases.at(sevirds::NVAC_POP).at(sevirds::SUSCEPTIBLE)); }
+    catch(nlohmann::detail::type_error &e) { AssertLong(false, __FILE__, __LINE__, "Error reading the susceptible vector from either default.json OR infectedCell.json\nVerify the format is [[#], [#], ...] and NOT [#, #, ...]"); }
 
-    json.at("recovered").get_to(current_sevirds.recovered);
-    json.at("recoveredD1").get_to(current_sevirds.recoveredD1);
-    json.at("recoveredD2").get_to(current_sevirds.recoveredD2);
+    for (unsigned int pop = 0; pop < num_population_types; ++pop)
+    {
+        for (unsigned int comp = sevirds::SUSCEPTIBLE; comp < sevirds::NUM_COMPARTMENTS; ++comp)
+        {
+            if (pop != sevirds::NVAC_POP || comp != sevirds::SUSCEPTIBLE)
+                json.at(phase_names.at(pop).at(comp)).get_to(phases.at(pop).at(comp));
+        }
+    }
 
-    json.at("fatalities").get_to(current_sevirds.fatalities);
+    vector<double> fatalities;
+    json.at("fatalities").get_to(fatalities);
 
     json.at("disobedient").get_to(current_sevirds.disobedient);
     json.at("hospital_capacity").get_to(current_sevirds.hospital_capacity);
     json.at("fatality_modifier").get_to(current_sevirds.fatality_modifier);
 
-    json.at("immunityD1").get_to(current_sevirds.immunityD1_rate);
-    json.at("immunityD2").get_to(current_sevirds.immunityD2_rate);
+    layout->immunity_rates.resize(num_population_types);
+    for (unsigned int pop = sevirds::DOSE1_POP; pop < num_population_types; ++pop)
+        json.at(immunity_names.at(pop)).get_to(layout->immunity_rates.at(pop));
+
     json.at("min_interval_between_doses").get_to(current_sevirds.min_interval_doses);
     json.at("min_interval_between_recovery_and_vaccine").get_to(current_sevirds.min_interval_recovery_to_vaccine);
-    
-    try
-    {
-        vector<vector<double>> buf;
-        int i = 1;
-        while(true)
-        {
-            json.at("booster"+to_string(i)).get_to(buf);
-            current_sevirds.boosters.push_back(buf);
-            
-            try
-            {
-                json.at("exposedB"+to_string(i)).get_to(buf);
-                current_sevirds.boosters_exposed.push_back(buf);
-                json.at("infectedB"+to_string(i)).get_to(buf);
-                current_sevirds.boosters_infected.push_back(buf);
-                json.at("recoveredB"+to_string(i)).get_to(buf);
-                current_sevirds.boosters_recovered.push_back(buf);
-                json.at("immunityB"+to_string(i)).get_to(buf);
-                current_sevirds.boosters_immunity_rates.push_back(buf);
-            }
-            catch (exception &e) { AssertLong(false, __FILE__, __LINE__, "Need matching exposed, infected, recovered, and immunity lists for booster"+to_string(i)); }
-            ++i;
-        }
-    } catch (exception &e) { }
 
-    current_sevirds.num_age_groups = current_sevirds.age_group_proportions.size();
+    current_sevirds.num_age_groups = layout->age_group_proportions.size();
     unsigned int age_groups        = current_sevirds.num_age_groups;
 
-    AssertLong(accumulate(current_sevirds.age_group_proportions.begin(), current_sevirds.age_group_proportions.end(), 0.0) == 1,
+    AssertLong(accumulate(layout->age_group_proportions.begin(), layout->age_group_proportions.end(), 0.0) == 1,
                 __FILE__, __LINE__,
                 "The age group proportions need to add up to 1");
 
     // Checks if the phases have the correct number of age groups
-    AssertLong(age_groups <= current_sevirds.susceptible.size() && age_groups <= current_sevirds.exposed.size() && age_groups <= current_sevirds.infected.size() &&
-                    age_groups <= current_sevirds.recovered.size() && age_groups <= current_sevirds.fatalities.size() && age_groups <= current_sevirds.vaccinatedD1.size() &&
-                    age_groups <= current_sevirds.vaccinatedD2.size() && age_groups <= current_sevirds.immunityD1_rate.size() && age_groups <= current_sevirds.immunityD2_rate.size() &&
-                    age_groups <= current_sevirds.exposedD1.size() && age_groups <= current_sevirds.infectedD2.size() && age_groups <= current_sevirds.recoveredD2.size() &&
-                    age_groups <= current_sevirds.exposedD2.size() && age_groups <= current_sevirds.infectedD2.size() && age_groups <= current_sevirds.recoveredD2.size(),
+    bool enough_age_groups = age_groups <= fatalities.size()
+                            && age_groups <= layout->immunity_rates.at(sevirds::DOSE1_POP).size()
+                            && age_groups <= layout->immunity_rates.at(sevirds::DOSE2_POP).size();
+
+    for (unsigned int pop = 0; pop < num_population_types; ++pop)
+    {
+        for (unsigned int comp = sevirds::SUSCEPTIBLE; comp < sevirds::NUM_COMPARTMENTS; ++comp)
+            enough_age_groups = enough_age_groups && age_groups <= phases.at(pop).at(comp).size();
+    }
+
+    AssertLong(enough_age_groups,
                 __FILE__, __LINE__,
                 "There must be at least " + to_string(age_groups) + " age groups for each of the lists under the 'states' parameter in default.json as well as in infectedCell.json");
 
+    // Lay every phase out one after the other in the flat buffer.
+    // All the age groups of a phase share its length so they can be indexed without a lookup.
+    layout->num_age_groups       = age_groups;
+    layout->num_population_types = num_population_types;
+
+    for (unsigned int comp = sevirds::SUSCEPTIBLE; comp < sevirds::NUM_COMPARTMENTS; ++comp)
+    {
+        for (unsigned int pop = 0; pop < num_population_types; ++pop)
+        {
+            sevirds::proportionVector const& phase = phases.at(pop).at(comp);
+            unsigned int days = (age_groups > 0) ? phase.front().size() : 0;
+
+            for (unsigned int a = 0; a < age_groups; ++a)
+            {
+                AssertLong(phase.at(a).size() == days,
+                            __FILE__, __LINE__,
+                            "Every age group of '" + phase_names.at(pop).at(comp) + "' needs the same number of days");
+            }
+
+            layout->days.push_back(days);
+            layout->offsets.push_back(layout->size);
+            layout->size += days * age_groups;
+        }
+    }
+
+    layout->fatalities_offset = layout->size;
+    layout->size             += age_groups;
+
+    // The fields of visit_fields() then the total exposed and infected proportions
+    layout->num_fields    = 11 + num_population_types - sevirds::BOOSTER_POP;
+    layout->totals_offset = layout->size;
+    layout->size         += layout->num_fields + 2;
+
+    current_sevirds.values.assign(layout->size, 0.0);
+    current_sevirds.heads.assign(sevirds::NUM_COMPARTMENTS * num_population_types * age_groups, 0);
+
+    for (unsigned int comp = sevirds::SUSCEPTIBLE; comp < sevirds::NUM_COMPARTMENTS; ++comp)
+    {
+        for (unsigned int pop = 0; pop < num_population_types; ++pop)
+        {
+            unsigned int block = comp * num_population_types + pop;
+
+            for (unsigned int a = 0; a < age_groups; ++a)
+            {
+                vector<double> const& days = phases.at(pop).at(comp).at(a);
+                copy(days.begin(), days.end(), current_sevirds.values.begin() + layout->offsets.at(block) + a * layout->days.at(block));
+            }
+        }
+    }
+
+    for (unsigned int a = 0; a < age_groups; ++a)
+        current_sevirds.values.at(layout->fatalities_offset + a) = fatalities.at(a);
+
+    current_sevirds.layout = layout;
+
     for (unsigned int a = 0; a < age_groups; ++a)
     {
-        double pop = current_sevirds.susceptible.at(a).front()
-                    + accumulate(current_sevirds.exposed.at(a).begin(),   current_sevirds.exposed.at(a).end(),   0.0)
-                    + accumulate(current_sevirds.infected.at(a).begin(),  current_sevirds.infected.at(a).end(),  0.0)
-                    + accumulate(current_sevirds.recovered.at(a).begin(), current_sevirds.recovered.at(a).end(), 0.0)
-                    + current_sevirds.fatalities.at(a)
-                    + accumulate(current_sevirds.vaccinatedD1.at(a).begin(), current_sevirds.vaccinatedD1.at(a).end(), 0.0)
-                    + accumulate(current_sevirds.vaccinatedD2.at(a).begin(), current_sevirds.vaccinatedD2.at(a).end(), 0.0)
-                    + accumulate(current_sevirds.exposedD1.at(a).begin(),    current_sevirds.exposedD1.at(a).end(),    0.0)
-                    + accumulate(current_sevirds.exposedD2.at(a).begin(),    current_sevirds.exposedD2.at(a).end(),    0.0)
-                    + accumulate(current_sevirds.infectedD1.at(a).begin(),   current_sevirds.infectedD1.at(a).end(),   0.0)
-                    + accumulate(current_sevirds.infectedD2.at(a).begin(),   current_sevirds.infectedD2.at(a).end(),   0.0)
-                    + accumulate(current_sevirds.recoveredD1.at(a).begin(),  current_sevirds.recoveredD1.at(a).end(),  0.0)
-                    + accumulate(current_sevirds.recoveredD2.at(a).begin(),  current_sevirds.recoveredD2.at(a).end(),  0.0);
+        double pop = current_sevirds.susceptible(a).front()
+                    + sevirds::sum_state_vector(current_sevirds.exposed(a))
+                    + sevirds::sum_state_vector(current_sevirds.infected(a))
+                    + sevirds::sum_state_vector(current_sevirds.recovered(a))
+                    + current_sevirds.fatalities(a)
+                    + sevirds::sum_state_vector(current_sevirds.vaccinatedD1(a))
+                    + sevirds::sum_state_vector(current_sevirds.vaccinatedD2(a))
+                    + sevirds::sum_state_vector(current_sevirds.exposedD1(a))
+                    + sevirds::sum_state_vector(current_sevirds.exposedD2(a))
+                    + sevirds::sum_state_vector(current_sevirds.infectedD1(a))
+                    + sevirds::sum_state_vector(current_sevirds.infectedD2(a))
+                    + sevirds::sum_state_vector(current_sevirds.recoveredD1(a))
+                    + sevirds::sum_state_vector(current_sevirds.recoveredD2(a));
 
         AssertLong(pop == 1.0, __FILE__, __LINE__, "The vectors don't add up to 1! " + to_string(pop) + " Double check the values in default.json AND infectedCell.json");
     }
@@ -601,7 +853,7 @@ void from_json(const nlohmann::json& json, sevirds& current_sevirds)
     }
 
     // Recovered Dose 1 can't be smaller then Susceptible Vaccinated Dose 1
-    AssertLong(current_sevirds.recoveredD1.front().size() >= current_sevirds.vaccinatedD1.front().size(),
+    AssertLong(current_sevirds.recoveredD1(0).size() >= current_sevirds.vaccinatedD1(0).size(),
                 __FILE__, __LINE__,
                 "The recovery phase for those vaccinated with their first dose needs to be smaller then vaccinatedD1!");
 }
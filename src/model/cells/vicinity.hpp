@@ -3,8 +3,12 @@
 #ifndef CELL_DEVS_ZHONG_DEVEL_VICINITY_H
 #define CELL_DEVS_ZHONG_DEVEL_VICINITY_H
 
+#include <algorithm>
 #include <functional>
 #include <cmath>
+#include <map>
+#include <memory>
+#include <vector>
 #include <nlohmann/json.hpp>
 #include "hysteresis_factor.hpp"
 
@@ -16,22 +20,81 @@ struct vicinity
     using mobility_correction_factor = array<float, 2>; // The first value is the mobility correction factor;
                                                              // The second one is the hysteresis factor.
 
-    map<infection_threshold, mobility_correction_factor> correction_factors;
+    // A movement restriction, in effect once the infections reach its threshold
+    struct correction_factor
+    {
+        infection_threshold threshold;
+        mobility_correction_factor factor;
+
+        // Where the hysteresis of the restriction ends, see geographical_equations::movement_correction_factor()
+        float infections_higher_bound; // Threshold of the next restriction, its own threshold for the last one
+        float infections_lower_bound;  // Threshold minus the hysteresis factor
+    };
+
+    using correction_profile = vector<correction_factor>; // Sorted by threshold
+
+    // Scenarios usually give every vicinity the same correction factors, so the vicinities with
+    // identical factors share one immutable profile (see correction_profile_store.hpp). None when null
+    shared_ptr<correction_profile const> correction_factors;
 
     double correlation = 1.0f;
 
     explicit vicinity(double correlation) : correlation{correlation} { }
 
     vicinity() { }
+
+    /**
+     * @brief Sorts the correction factors of a scenario into a profile and works out their hysteresis bounds
+     *
+     * @param factors Mobility correction and hysteresis factors by infection threshold
+     * @return shared_ptr<correction_profile const>
+    */
+    static shared_ptr<correction_profile const> make_correction_profile(map<infection_threshold, mobility_correction_factor> const& factors)
+    {
+        auto profile = make_shared<correction_profile>();
+        for (auto const& factor : factors)
+            profile->push_back({factor.first, factor.second, factor.first, factor.first - factor.second.back()});
+
+        for (unsigned int i = 0; i + 1 < profile->size(); ++i)
+            profile->at(i).infections_higher_bound = profile->at(i + 1).threshold;
+
+        return profile;
+    }
+
+    correction_profile const& profile() const
+    {
+        static correction_profile const none;
+        return correction_factors ? *correction_factors : none;
+    }
+
+    /**
+     * @brief The restriction in effect for a proportion of infections
+     *
+     * @param infections Total infections of the cell
+     * @return correction_factor const* The factor with the highest threshold reached by the infections, nullptr if none is
+    */
+    correction_factor const* correction_factor_for(double infections) const
+    {
+        correction_profile const& factors = profile();
+        auto above = upper_bound(factors.begin(), factors.end(), infections,
+                                    [](double value, correction_factor const& factor) { return value < factor.threshold; });
+
+        return above == factors.begin() ? nullptr : &*(above - 1);
+    }
 };
 
-void from_json(const nlohmann::json& json, vicinity& vicinity)
+/**
+ * @brief Parses the "infection_correction_factors" of a vicinity or a profile of "correction_profiles"
+ *
+ * @param json Mobility correction and hysteresis factors keyed by infection threshold
+ * @return shared_ptr<vicinity::correction_profile const>
+*/
+shared_ptr<vicinity::correction_profile const> parse_correction_profile(nlohmann::json const& json)
 {
-    json.at("correlation").get_to(vicinity.correlation);
-
     map<string, array<float, 2>> unparsed_infection_correction_factors;
+    map<vicinity::infection_threshold, vicinity::mobility_correction_factor> correction_factors;
 
-    json.at("infection_correction_factors").get_to(unparsed_infection_correction_factors);
+    json.get_to(unparsed_infection_correction_factors);
 
     for (const auto& i : unparsed_infection_correction_factors)
     {
@@ -71,8 +134,21 @@ void from_json(const nlohmann::json& json, vicinity& vicinity)
             throw runtime_error{error_message};
         }
 
-        vicinity.correction_factors.insert({infection_threshold, i.second});
+        correction_factors.insert({infection_threshold, i.second});
     }
+
+    return vicinity::make_correction_profile(correction_factors);
+} //parse_correction_profile()
+
+void from_json(const nlohmann::json& json, vicinity& vicinity)
+{
+    json.at("correlation").get_to(vicinity.correlation);
+
+    nlohmann::json const& factors = json.at("infection_correction_factors");
+    if (factors.is_string())
+        throw invalid_argument{"The correction profile " + factors.get<string>() + " can only be used by a scenario loaded with load_scenario()"};
+
+    vicinity.correction_factors = parse_correction_profile(factors);
 } //from_json()
 
 #endif //CELL_DEVS_ZHONG_DEVEL_VICINITY_H
\ No newline at end of file
@@ -0,0 +1,279 @@
+#ifndef PANDEMIC_HOYA_2002_CHECKPOINT_HPP
+#define PANDEMIC_HOYA_2002_CHECKPOINT_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "binary_state_log.hpp"
+#include "cells/sevirds.hpp"
+#include "cells/hysteresis_factor.hpp"
+#include "Helpers/binary_io.hpp"
+#include "Helpers/Assert.hpp"
+
+using namespace std;
+
+/**
+ * Everything a simulation needs to carry on from the end of a day: the time of the next day,
+ * and for every cell its state and whether it changed on the last day, which decides who transitions next.
+ * Along with them, where the logs of the simulation were at the end of the day so a resumed simulation
+ * carries them on from there, dropping what was logged after the checkpoint.
+ *
+ * All the values are in the byte order of the machine that ran the simulation:
+ *   header: magic "SEVIRDSK", version, byte order mark (0x01020304), time of the next day, number of cells
+ *   cells:  id, changed, population, flat buffer of the phases, heads of the phase rings, hysteresis factors
+ *   logs:   number of logs then the name and size of each, the day table of the binary state log,
+ *           and whether each cell transitioned since the last day the state log logged
+ *
+ * Only the parts of the states that change during a simulation are saved, the rest comes from the scenario.
+*/
+struct checkpoint
+{
+    static constexpr char magic[8]     = {'S', 'E', 'V', 'I', 'R', 'D', 'S', 'K'};
+    static constexpr uint32_t version    = 3;
+    static constexpr uint32_t byte_order = 0x01020304;
+
+    // The parts of a state that change during a simulation, along with the hysteresis kept by the equations of the cell
+    struct saved_state
+    {
+        double population = 0;
+        vector<double> values;
+        vector<unsigned int> heads;
+        vector<hysteresis_factor> hysteresis_factors;
+
+        saved_state() = default;
+
+        saved_state(sevirds const& state, vector<hysteresis_factor> const& hysteresis_factors) :
+            population{state.population}, values{state.values}, heads{state.heads}, hysteresis_factors{hysteresis_factors} { }
+    };
+
+    double time = 0;
+    vector<string> ids;
+    vector<char> changed;
+    vector<saved_state> states;
+
+    map<string, uint64_t> log_sizes; // Size of each log written, by name: "state", "messages", "binary_log", "viewer"...
+    vector<binary_state_log::day_entry> binary_log_days;
+    vector<char> log_pending;
+
+    /**
+     * @brief Reads a checkpoint written by a checkpoint_writer
+     *
+     * @param path Path to the checkpoint
+     * @return checkpoint
+    */
+    static checkpoint read(string const& path)
+    {
+        mapped_file file(path);
+        binary_reader in(file.data(), file.size(), path);
+
+        char file_magic[sizeof(magic)] = {};
+        in.read_array(file_magic, sizeof(file_magic));
+        AssertLong(memcmp(file_magic, magic, sizeof(magic)) == 0, __FILE__, __LINE__, path + " is not a checkpoint");
+        AssertLong(in.read<uint32_t>() == version, __FILE__, __LINE__, path + " was written by another version of the simulator");
+        AssertLong(in.read<uint32_t>() == byte_order, __FILE__, __LINE__, path + " was written on a machine of another byte order");
+
+        checkpoint saved;
+        saved.time = in.read<double>();
+
+        uint32_t num_cells = in.read<uint32_t>();
+        for (uint32_t i = 0; i < num_cells; ++i)
+        {
+            saved.ids.push_back(in.read_string());
+            saved.changed.push_back(in.read<uint8_t>());
+
+            saved_state state;
+            state.population         = in.read<double>();
+            state.values             = in.read_vector<double>();
+            state.heads              = in.read_vector<unsigned int>();
+            state.hysteresis_factors = in.read_vector<hysteresis_factor>();
+            saved.states.push_back(move(state));
+        }
+
+        uint32_t num_logs = in.read<uint32_t>();
+        for (uint32_t i = 0; i < num_logs; ++i)
+        {
+            string name           = in.read_string();
+            saved.log_sizes[name] = in.read<uint64_t>();
+        }
+
+        uint32_t num_days = in.read<uint32_t>();
+        for (uint32_t i = 0; i < num_days; ++i)
+        {
+            binary_state_log::day_entry entry;
+            entry.time    = in.read<double>();
+            entry.offset  = in.read<uint64_t>();
+            entry.records = in.read<uint32_t>();
+            saved.binary_log_days.push_back(entry);
+        }
+
+        saved.log_pending = in.read_vector<char>();
+        return saved;
+    }
+
+    /**
+     * @brief Puts the saved parts of the state of a cell back
+     *
+     * @param cell Index of the cell in the checkpoint
+     * @param id ID the cell has in the scenario
+     * @param state State of the cell, loaded from the scenario
+     * @param hysteresis_factors Hysteresis kept by the equations of the cell, one per neighbor
+    */
+    void restore(unsigned int cell, string const& id, sevirds& state, vector<hysteresis_factor>& hysteresis_factors) const
+    {
+        AssertLong(cell < ids.size() && ids[cell] == id, __FILE__, __LINE__,
+                    "The cells of the checkpoint are not those of the scenario, " + id + " is not where it was");
+
+        saved_state const& saved = states[cell];
+        AssertLong(saved.values.size() == state.values.size() && saved.heads.size() == state.heads.size()
+                    && saved.hysteresis_factors.size() == hysteresis_factors.size(), __FILE__, __LINE__,
+                    "The state of " + id + " in the checkpoint doesn't have the shape it has in the scenario");
+
+        state.population         = saved.population;
+        state.values             = saved.values;
+        state.heads              = saved.heads;
+        hysteresis_factors       = saved.hysteresis_factors;
+        state.update_totals();
+    }
+
+    /**
+     * @brief Size a log had when the checkpoint was written, a resumed simulation carries it on from there
+     *
+     * @param log Name of the log
+     * @param option Option the log is written with, for the error message
+     * @return streamoff
+    */
+    streamoff log_size(string const& log, string const& option) const
+    {
+        auto size = log_sizes.find(log);
+        if (size == log_sizes.end())
+            throw runtime_error{option + " can only be given when resuming a simulation that was written with it"};
+
+        return size->second;
+    }
+
+    /**
+     * @brief Makes sure a checkpoint holds every cell of the scenario
+     *
+     * @param num_cells Number of cells of the scenario
+    */
+    void check_size(unsigned int num_cells) const
+    {
+        AssertLong(ids.size() == num_cells, __FILE__, __LINE__, "The checkpoint has " + to_string(ids.size())
+                    + " cells but the scenario has " + to_string(num_cells));
+    }
+}; //struct checkpoint{}
+
+/**
+ * Writes checkpoints from a background thread so the simulation only waits for its states to be copied.
+ * A checkpoint is first written next to the previous one then renamed over it, so there always is a
+ * complete checkpoint even if the simulation is killed halfway through writing one.
+*/
+class checkpoint_writer
+{
+    string path;
+    thread writer;
+    exception_ptr error; // Thrown by the background thread, rethrown by wait()
+
+    public:
+        explicit checkpoint_writer(string path) : path{move(path)} { }
+
+        ~checkpoint_writer()
+        {
+            if (writer.joinable())
+                writer.join();
+        }
+
+        checkpoint_writer(checkpoint_writer const&)            = delete;
+        checkpoint_writer& operator=(checkpoint_writer const&) = delete;
+
+        /**
+         * @brief Writes a checkpoint once the previous one is written
+         *
+         * @param saved Checkpoint to write, a copy of the states of the simulation
+        */
+        void write(checkpoint saved)
+        {
+            wait();
+            writer = thread([this, saved = move(saved)]() {
+                try { write_file(saved); }
+                catch (...) { error = current_exception(); }
+            });
+        }
+
+        /**
+         * @brief Waits for the checkpoint being written, if any, and rethrows what went wrong writing it
+        */
+        void wait()
+        {
+            if (writer.joinable())
+                writer.join();
+
+            if (error)
+                rethrow_exception(exchange(error, nullptr));
+        }
+
+    private:
+        void write_file(checkpoint const& saved) const
+        {
+            string partial_path = path + ".partial";
+
+            {
+                ofstream file(partial_path, ios::binary);
+                if (!file.is_open())
+                    throw runtime_error{"Unable to open the file: " + partial_path};
+
+                binary_writer out(file);
+                file.write(checkpoint::magic, sizeof(checkpoint::magic));
+                out.write(checkpoint::version);
+                out.write(checkpoint::byte_order);
+                out.write(saved.time);
+                out.write<uint32_t>(saved.ids.size());
+
+                for (unsigned int i = 0; i < saved.ids.size(); ++i)
+                {
+                    checkpoint::saved_state const& state = saved.states[i];
+                    out.write_string(saved.ids[i]);
+                    out.write<uint8_t>(saved.changed[i]);
+                    out.write(state.population);
+                    out.write_vector(state.values);
+                    out.write_vector(state.heads);
+                    out.write_vector(state.hysteresis_factors);
+                }
+
+                out.write<uint32_t>(saved.log_sizes.size());
+                for (auto const& log : saved.log_sizes)
+                {
+                    out.write_string(log.first);
+                    out.write(log.second);
+                }
+
+                out.write<uint32_t>(saved.binary_log_days.size());
+                for (binary_state_log::day_entry const& entry : saved.binary_log_days)
+                {
+                    out.write(entry.time);
+                    out.write(entry.offset);
+                    out.write(entry.records);
+                }
+
+                out.write_vector(saved.log_pending);
+
+                file.close();
+                AssertLong(!file.fail(), __FILE__, __LINE__, "Unable to write the checkpoint " + partial_path);
+            }
+
+#ifdef _WIN32
+            // rename() only replaces an existing file on POSIX systems
+            remove(path.c_str());
+#endif
+            AssertLong(rename(partial_path.c_str(), path.c_str()) == 0, __FILE__, __LINE__, "Unable to replace the checkpoint " + path);
+        }
+}; //class checkpoint_writer{}
+
+#endif //PANDEMIC_HOYA_2002_CHECKPOINT_HPP
@@ -0,0 +1,362 @@
+#ifndef PANDEMIC_HOYA_2002_COMPILED_SCENARIO_HPP
+#define PANDEMIC_HOYA_2002_COMPILED_SCENARIO_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "scenario_loader.hpp"
+#include "Helpers/binary_io.hpp"
+#include "Helpers/Assert.hpp"
+
+using namespace std;
+
+/**
+ * A scenario converted once by the compile-scenario tool so it can be loaded without parsing
+ * or validating any json. Everything cells usually repeat is only stored once and shared:
+ * the strings, the configurations, the layouts of the states and the correction factors of the vicinities.
+ *
+ * All the values are in the byte order of the machine that compiled the scenario:
+ *   header:  magic "SEVIRDSC", version, byte order mark (0x01020304)
+ *   tables:  strings, configurations, state layouts, correction factors
+ *   cells:   id, type, delay, configuration and layout, the scalars of the state, its flat buffer
+ *            then its neighbors (id, correlation and correction factors) sorted by id
+*/
+namespace compiled_scenario
+{
+    static char const magic[8]          = {'S', 'E', 'V', 'I', 'R', 'D', 'S', 'C'};
+    static uint32_t const version       = 2;
+    static uint32_t const byte_order    = 0x01020304;
+
+    using correction_factors = vicinity::correction_profile;
+
+    void write_rates(binary_writer& out, vector<vector<double>> const& rates)
+    {
+        out.write<uint32_t>(rates.size());
+        for (vector<double> const& row : rates)
+            out.write_vector(row);
+    }
+
+    vector<vector<double>> read_rates(binary_reader& in)
+    {
+        vector<vector<double>> rates(in.read<uint32_t>());
+        for (vector<double>& row : rates)
+            row = in.read_vector<double>();
+
+        return rates;
+    }
+
+    void write_booster_rates(binary_writer& out, vector<simulation_config::phase_rates> const& boosters)
+    {
+        out.write<uint32_t>(boosters.size());
+        for (simulation_config::phase_rates const& rates : boosters)
+            write_rates(out, rates);
+    }
+
+    vector<simulation_config::phase_rates> read_booster_rates(binary_reader& in)
+    {
+        vector<simulation_config::phase_rates> boosters(in.read<uint32_t>());
+        for (simulation_config::phase_rates& rates : boosters)
+            rates = read_rates(in);
+
+        return boosters;
+    }
+
+    void write_config(binary_writer& out, simulation_config const& config)
+    {
+        out.write<int32_t>(config.prec_divider);
+
+        for (auto rates : {&config.virulence_rates, &config.incubation_rates, &config.incubationD1_rates, &config.incubationD2_rates,
+                            &config.recovery_rates, &config.recovery_ratesD1, &config.recovery_ratesD2, &config.mobility_rates,
+                            &config.fatality_rates, &config.fatality_ratesD1, &config.fatality_ratesD2, &config.vac1_rates, &config.vac2_rates})
+            write_rates(out, *rates);
+
+        write_booster_rates(out, config.boosters_incubation_rates);
+        write_booster_rates(out, config.boosters_recovery_rates);
+        write_booster_rates(out, config.boosters_fatality_rates);
+        write_booster_rates(out, config.boosters_vaccination_rates);
+
+        out.write<uint8_t>(config.reSusceptibility);
+        out.write<uint8_t>(config.is_vaccination);
+    }
+
+    shared_ptr<simulation_config const> read_config(binary_reader& in)
+    {
+        shared_ptr<simulation_config> config = make_shared<simulation_config>();
+        config->prec_divider = in.read<int32_t>();
+
+        for (auto rates : {&config->virulence_rates, &config->incubation_rates, &config->incubationD1_rates, &config->incubationD2_rates,
+                            &config->recovery_rates, &config->recovery_ratesD1, &config->recovery_ratesD2, &config->mobility_rates,
+                            &config->fatality_rates, &config->fatality_ratesD1, &config->fatality_ratesD2, &config->vac1_rates, &config->vac2_rates})
+            *rates = read_rates(in);
+
+        config->boosters_incubation_rates  = read_booster_rates(in);
+        config->boosters_recovery_rates    = read_booster_rates(in);
+        config->boosters_fatality_rates    = read_booster_rates(in);
+        config->boosters_vaccination_rates = read_booster_rates(in);
+
+        config->reSusceptibility = in.read<uint8_t>();
+        config->is_vaccination   = in.read<uint8_t>();
+        return config;
+    }
+
+    void write_layout(binary_writer& out, sevirds_layout const& layout)
+    {
+        out.write<uint32_t>(layout.num_age_groups);
+        out.write<uint32_t>(layout.num_population_types);
+        out.write_vector(layout.days);
+        out.write_vector(layout.offsets);
+        out.write<uint32_t>(layout.fatalities_offset);
+        out.write<uint32_t>(layout.totals_offset);
+        out.write<uint32_t>(layout.num_fields);
+        out.write<uint32_t>(layout.size);
+        out.write_vector(layout.age_group_proportions);
+
+        out.write<uint32_t>(layout.immunity_rates.size());
+        for (sevirds_layout::rateVector const& rates : layout.immunity_rates)
+            write_rates(out, rates);
+    }
+
+    shared_ptr<sevirds_layout const> read_layout(binary_reader& in)
+    {
+        shared_ptr<sevirds_layout> layout = make_shared<sevirds_layout>();
+        layout->num_age_groups        = in.read<uint32_t>();
+        layout->num_population_types  = in.read<uint32_t>();
+        layout->days                  = in.read_vector<unsigned int>();
+        layout->offsets               = in.read_vector<unsigned int>();
+        layout->fatalities_offset     = in.read<uint32_t>();
+        layout->totals_offset         = in.read<uint32_t>();
+        layout->num_fields            = in.read<uint32_t>();
+        layout->size                  = in.read<uint32_t>();
+        layout->age_group_proportions = in.read_vector<double>();
+
+        layout->immunity_rates.resize(in.read<uint32_t>());
+        for (sevirds_layout::rateVector& rates : layout->immunity_rates)
+            rates = read_rates(in);
+
+        return layout;
+    }
+
+    void write_correction_factors(binary_writer& out, correction_factors const& factors)
+    {
+        out.write<uint32_t>(factors.size());
+        for (vicinity::correction_factor const& factor : factors)
+        {
+            out.write(factor.threshold);
+            out.write(factor.factor);
+        }
+    }
+
+    shared_ptr<correction_factors const> read_correction_factors(binary_reader& in)
+    {
+        map<vicinity::infection_threshold, vicinity::mobility_correction_factor> factors;
+        for (uint32_t count = in.read<uint32_t>(); count > 0; --count)
+        {
+            vicinity::infection_threshold threshold = in.read<vicinity::infection_threshold>();
+            factors.emplace_hint(factors.end(), threshold, in.read<vicinity::mobility_correction_factor>());
+        }
+
+        return vicinity::make_correction_profile(factors);
+    }
+
+    /**
+     * Hands out the index of every distinct entry of a table, the entries being compared by their bytes
+    */
+    class table_builder
+    {
+        unordered_map<string, uint32_t> indices;
+        ostringstream entries;
+
+        public:
+            template <typename WRITE_ENTRY>
+            uint32_t index(WRITE_ENTRY&& write_entry)
+            {
+                ostringstream bytes;
+                binary_writer entry(bytes);
+                write_entry(entry);
+
+                auto it = indices.find(bytes.str());
+                if (it == indices.end())
+                {
+                    it = indices.emplace(bytes.str(), indices.size()).first;
+                    entries << bytes.str();
+                }
+
+                return it->second;
+            }
+
+            void write(binary_writer& out, ostream& stream)
+            {
+                out.write<uint32_t>(indices.size());
+                stream << entries.str();
+            }
+    }; //class table_builder{}
+
+    /**
+     * @brief Converts a json scenario to a compiled scenario.
+     * The scenario is validated like it would be when running it
+     *
+     * @param scenario_path Path to the scenario json file
+     * @param compiled_path Path of the compiled scenario to write
+     * @return unsigned int Number of cells in the scenario
+    */
+    unsigned int compile(string const& scenario_path, string const& compiled_path)
+    {
+        config_store configs;
+        table_builder strings, config_table, layouts, factors;
+
+        ostringstream cells;
+        binary_writer cell_writer(cells);
+        unsigned int num_cells = 0;
+
+        load_scenario(scenario_path, configs, [&](scenario_cell&& cell) {
+            auto string_index = [&](string const& text) { return strings.index([&](binary_writer& out) { out.write_string(text); }); };
+
+            cell_writer.write<uint32_t>(string_index(cell.id));
+            cell_writer.write<uint32_t>(string_index(cell.cell_type));
+            cell_writer.write<uint32_t>(string_index(cell.delay));
+            cell_writer.write<uint32_t>(config_table.index([&](binary_writer& out) { write_config(out, *cell.config); }));
+            cell_writer.write<uint32_t>(layouts.index([&](binary_writer& out) { write_layout(out, *cell.state.layout); }));
+
+            sevirds const& state = cell.state;
+            cell_writer.write<double>(state.population);
+            cell_writer.write<double>(state.disobedient);
+            cell_writer.write<double>(state.hospital_capacity);
+            cell_writer.write<double>(state.fatality_modifier);
+            cell_writer.write<uint32_t>(state.min_interval_doses);
+            cell_writer.write<uint32_t>(state.min_interval_recovery_to_vaccine);
+            cell_writer.write_array(state.values.data(), state.values.size());
+
+            // Sorted like in the json object so the neighborhood is rebuilt in the same order
+            vector<pair<string, vicinity const*>> neighbors;
+            for (auto const& neighbor : cell.neighborhood)
+                neighbors.emplace_back(neighbor.first, &neighbor.second);
+            sort(neighbors.begin(), neighbors.end());
+
+            cell_writer.write<uint32_t>(neighbors.size());
+            for (auto const& neighbor : neighbors)
+            {
+                cell_writer.write<uint32_t>(string_index(neighbor.first));
+                cell_writer.write<double>(neighbor.second->correlation);
+                cell_writer.write<uint32_t>(factors.index([&](binary_writer& out) { write_correction_factors(out, neighbor.second->profile()); }));
+            }
+
+            ++num_cells;
+        });
+
+        ofstream file(compiled_path, ios::binary);
+        if (!file.is_open())
+            throw runtime_error{"Unable to open the file: " + compiled_path};
+
+        binary_writer out(file);
+        file.write(magic, sizeof(magic));
+        out.write(version);
+        out.write(byte_order);
+
+        strings.write(out, file);
+        config_table.write(out, file);
+        layouts.write(out, file);
+        factors.write(out, file);
+
+        out.write<uint32_t>(num_cells);
+        file << cells.str();
+
+        AssertLong(file.good(), __FILE__, __LINE__, "Unable to write the compiled scenario " + compiled_path);
+        return num_cells;
+    }
+
+    /**
+     * @brief Tells if a file is a compiled scenario rather than a json one
+     *
+     * @param file_path Path to the scenario
+     * @return bool
+    */
+    bool is_compiled(string const& file_path)
+    {
+        ifstream file(file_path, ios::binary);
+        char header[sizeof(magic)] = {};
+        file.read(header, sizeof(header));
+
+        return file.good() && equal(header, header + sizeof(header), magic);
+    }
+
+    /**
+     * @brief Reads the cells of a compiled scenario, handing them out in the same order and with
+     * the same contents load_scenario() does for the json scenario it was compiled from.
+     * The file is memory mapped and nothing is validated again
+     *
+     * @param file_path Path to the compiled scenario
+     * @param add_cell Called with every scenario_cell of the scenario
+    */
+    template <typename ADD_CELL>
+    void load(string const& file_path, ADD_CELL&& add_cell)
+    {
+        mapped_file file(file_path);
+        binary_reader in(file.data(), file.size(), "the compiled scenario " + file_path);
+
+        char header[sizeof(magic)];
+        in.read_array(header, sizeof(header));
+        AssertLong(equal(header, header + sizeof(header), magic), __FILE__, __LINE__, file_path + " is not a compiled scenario");
+        AssertLong(in.read<uint32_t>() == version, __FILE__, __LINE__,
+                    file_path + " was compiled by another version of compile-scenario, it needs to be compiled again");
+        AssertLong(in.read<uint32_t>() == byte_order, __FILE__, __LINE__,
+                    file_path + " was compiled on a machine with another byte order, it needs to be compiled again");
+
+        vector<string> strings(in.read<uint32_t>());
+        for (string& text : strings)
+            text = in.read_string();
+
+        vector<shared_ptr<simulation_config const>> configs(in.read<uint32_t>());
+        for (shared_ptr<simulation_config const>& config : configs)
+            config = read_config(in);
+
+        vector<shared_ptr<sevirds_layout const>> layouts(in.read<uint32_t>());
+        for (shared_ptr<sevirds_layout const>& layout : layouts)
+            layout = read_layout(in);
+
+        // Shared by every vicinity using them, like they are when the json scenario is loaded
+        vector<shared_ptr<correction_factors const>> factors(in.read<uint32_t>());
+        for (shared_ptr<correction_factors const>& factor : factors)
+            factor = read_correction_factors(in);
+
+        for (uint32_t num_cells = in.read<uint32_t>(); num_cells > 0; --num_cells)
+        {
+            scenario_cell cell;
+            cell.id        = strings.at(in.read<uint32_t>());
+            cell.cell_type = strings.at(in.read<uint32_t>());
+            cell.delay     = strings.at(in.read<uint32_t>());
+            cell.config    = configs.at(in.read<uint32_t>());
+
+            sevirds& state                         = cell.state;
+            state.layout                           = layouts.at(in.read<uint32_t>());
+            state.population                       = in.read<double>();
+            state.disobedient                      = in.read<double>();
+            state.hospital_capacity                = in.read<double>();
+            state.fatality_modifier                = in.read<double>();
+            state.min_interval_doses               = in.read<uint32_t>();
+            state.min_interval_recovery_to_vaccine = in.read<uint32_t>();
+            state.num_age_groups                   = state.layout->num_age_groups;
+
+            state.values.resize(state.layout->size);
+            in.read_array(state.values.data(), state.values.size());
+            state.heads.assign(sevirds::NUM_COMPARTMENTS * state.layout->num_population_types * state.num_age_groups, 0);
+
+            for (uint32_t num_neighbors = in.read<uint32_t>(); num_neighbors > 0; --num_neighbors)
+            {
+                string const& neighbor = strings.at(in.read<uint32_t>());
+
+                vicinity& v          = cell.neighborhood[neighbor];
+                v.correlation        = in.read<double>();
+                v.correction_factors = factors.at(in.read<uint32_t>());
+            }
+
+            add_cell(move(cell));
+        }
+    }
+} //namespace compiled_scenario
+
+#endif //PANDEMIC_HOYA_2002_COMPILED_SCENARIO_HPP
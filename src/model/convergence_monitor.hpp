@@ -0,0 +1,183 @@
+#ifndef PANDEMIC_HOYA_2002_CONVERGENCE_MONITOR_HPP
+#define PANDEMIC_HOYA_2002_CONVERGENCE_MONITOR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include "weighted_rows.hpp"
+#include "cells/sevirds.hpp"
+
+using namespace std;
+
+/**
+ * Tells a runner to stop once the epidemic is over rather than simulating the days left until the end time.
+ *
+ * Extinction: the exposed and infected proportion of every cell is below a threshold, by default
+ * the precision of the cell (1 / prec_divider).
+ * Steady state: none of the population weighted proportions of the whole scenario (the fields of
+ * visit_fields()) moves by more than a tolerance in a day, by default the finest precision of the cells.
+ *
+ * Either criterion has to hold for a number of days in a row. Only the cells that changed state on a
+ * day are looked at again, the others keep what was computed for them.
+*/
+class convergence_monitor
+{
+    public:
+        enum criterion
+        {
+            NONE,
+            EXTINCTION,
+            STEADY_STATE
+        };
+
+    private:
+        unsigned int extinction_days = 0; // 0 when the criterion isn't used
+        double extinction_threshold  = -1; // Below 0 for the precision of each cell
+        unsigned int steady_days     = 0;
+        double steady_tolerance      = -1;
+
+        vector<char> infected;          // Is the exposed and infected proportion of each cell above its threshold?
+        unsigned int num_infected = 0;
+
+        weighted_rows weighted;
+        vector<double> totals, previous_totals;
+        double tolerance = 0;
+
+        unsigned int extinct_for = 0, steady_for = 0;
+        criterion met = NONE;
+
+    public:
+        /**
+         * @brief Stops the simulation once nobody is exposed or infected anymore
+         *
+         * @param days Number of days in a row the epidemic has to be extinct for
+         * @param threshold Exposed and infected proportion under which a cell is free of the epidemic, the precision of the cell if below 0
+        */
+        void stop_on_extinction(unsigned int days, double threshold=-1)
+        {
+            extinction_days      = days;
+            extinction_threshold = threshold;
+        }
+
+        /**
+         * @brief Stops the simulation once the proportions of the whole scenario don't move anymore
+         *
+         * @param days Number of days in a row the proportions have to stay put
+         * @param tolerance Largest daily change of a proportion still seen as steady, the finest precision of the cells if below 0
+        */
+        void stop_on_steady_state(unsigned int days, double tolerance=-1)
+        {
+            steady_days      = days;
+            steady_tolerance = tolerance;
+        }
+
+        /**
+         * @brief Looks at the initial states of the cells
+         *
+         * @param num_cells Number of cells
+         * @param state Gives the state of the cell at an index
+        */
+        template <typename STATE>
+        void start(unsigned int num_cells, STATE&& state)
+        {
+            extinct_for = steady_for = 0;
+            met = NONE;
+
+            infected.assign(num_cells, 0);
+            num_infected = 0;
+            for (unsigned int i = 0; extinction_days > 0 && i < num_cells; ++i)
+                check_infected(i, state(i));
+
+            if (steady_days == 0)
+                return;
+
+            tolerance = steady_tolerance;
+            if (tolerance < 0)
+            {
+                tolerance = numeric_limits<double>::max();
+                for (unsigned int i = 0; i < num_cells; ++i)
+                    tolerance = min(tolerance, state(i).one_over_prec_divider);
+            }
+
+            weighted.start(num_cells, state);
+            weighted.sum(totals);
+        }
+
+        /**
+         * @brief Looks at the end of a day
+         *
+         * @param changed Has each cell changed state on the day?
+         * @param state Gives the state of the cell at an index
+         * @return bool Should the simulation stop?
+        */
+        template <typename STATE>
+        bool day(vector<char> const& changed, STATE&& state)
+        {
+            if (extinction_days > 0)
+            {
+                for (unsigned int i = 0; i < changed.size(); ++i)
+                {
+                    if (changed[i])
+                        check_infected(i, state(i));
+                }
+
+                extinct_for = num_infected == 0 ? extinct_for + 1 : 0;
+                if (extinct_for >= extinction_days)
+                    met = EXTINCTION;
+            }
+
+            if (steady_days > 0)
+            {
+                weighted.update(changed, state);
+                previous_totals.swap(totals);
+                weighted.sum(totals);
+
+                bool steady = true;
+                for (unsigned int f = 1; f < weighted.fields() && steady; ++f)
+                    steady = fabs(proportion(totals, f) - proportion(previous_totals, f)) <= tolerance;
+
+                steady_for = steady ? steady_for + 1 : 0;
+                if (steady_for >= steady_days && met == NONE)
+                    met = STEADY_STATE;
+            }
+
+            return met != NONE;
+        }
+
+        bool enabled() const { return extinction_days > 0 || steady_days > 0; }
+
+        // The criterion that stopped the simulation, NONE if it ran until its end time
+        criterion reason() const { return met; }
+
+        static string name(criterion reason)
+        {
+            switch (reason)
+            {
+                case EXTINCTION:   return "the epidemic is extinct";
+                case STEADY_STATE: return "the proportions reached a steady state";
+                default:           return "it reached its end time";
+            }
+        }
+
+    private:
+        void check_infected(unsigned int cell, sevirds const& state)
+        {
+            double threshold = extinction_threshold < 0 ? state.one_over_prec_divider : extinction_threshold;
+            bool now = state.total_exposed() + state.total_infections() >= threshold;
+
+            if (now && !infected[cell])
+                ++num_infected;
+            else if (!now && infected[cell])
+                --num_infected;
+            infected[cell] = now;
+        }
+
+        static double proportion(vector<double> const& totals, unsigned int field)
+        {
+            return totals[0] == 0 ? totals[field] : totals[field] / totals[0];
+        }
+}; //class convergence_monitor{}
+
+#endif //PANDEMIC_HOYA_2002_CONVERGENCE_MONITOR_HPP
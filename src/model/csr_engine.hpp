@@ -0,0 +1,467 @@
+#ifndef PANDEMIC_HOYA_2002_CSR_ENGINE_HPP
+#define PANDEMIC_HOYA_2002_CSR_ENGINE_HPP
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "compiled_scenario.hpp"
+#include "scenario_loader.hpp"
+#include "cells/cell_registry.hpp"
+#include "cells/config_store.hpp"
+#include "cells/geographical_equations.hpp"
+#include "checkpoint.hpp"
+#include "run_recorder.hpp"
+#include "Helpers/work_stealing_pool.hpp"
+#include "Helpers/Assert.hpp"
+
+using namespace std;
+
+/**
+ * Synchronous engine running the equations of geographical_equations.hpp without Cadmium.
+ *
+ * The neighborhoods are stored as CSR arrays: the neighbors of cell i are the entries
+ * row_start[i] to row_start[i + 1] of columns (index of the neighbor) and vicinities
+ * (correlation weight and correction factors). The equations and the states of the cells are kept
+ * in pages of page_size cells holding two arrays of states: every cell reads its neighbors from the
+ * states of the previous day and writes its own new state in the other array, then the engine
+ * switches arrays for the next day.
+ *
+ * A cell transitions on a day if itself or one of its neighbors changed state the day before,
+ * and keeps its old state when the new one isn't different, like it does under Cadmium.
+ * The logs are written by run_recorder in the same format as the Cadmium loggers.
+ *
+ * With compact messages each cell publishes an infectious_pressure summary of its state whenever
+ * it changes, and its neighbors read that summary instead of walking through its whole state.
+ *
+ * An engine can be forked where its run stopped to try what-if branches, see branch_spec.hpp. The forks share
+ * the neighborhoods and the pages of cells with it, copy on write: an engine copies a page it shares once it
+ * has to change one of its cells, so a branch changing a few cells only copies their pages, and a page whose
+ * cells never transition stays shared while the branch runs.
+*/
+class csr_engine : public run_recorder
+{
+    using TIME = float;
+
+    // The cells and their neighborhoods, they never change once loaded so the forks of an engine share them
+    struct csr_topology
+    {
+        cell_registry registry; // Cells are indexed in the order of their IDs, like the Cadmium runner adds them
+        vector<unsigned int> row_start;
+        vector<unsigned int> columns;
+        vector<vicinity> vicinities;
+        vector<unsigned int> self_position; // Position of each cell in its own row
+    };
+
+    shared_ptr<csr_topology const> topology;
+
+    // Cells page_size at a time, the last page holds the cells left
+    struct cell_page
+    {
+        vector<geographical_equations> equations;
+        vector<sevirds> states[2];             // See now
+        vector<infectious_pressure> pressures; // Published by each cell when using compact messages
+    };
+
+    // Shared with the engine this one was forked from and with the forks of this one until own_page()
+    vector<shared_ptr<cell_page>> pages;
+    unsigned int now = 0; // Array of states of the pages holding the states at the end of the previous day
+
+    bool compact;
+
+    work_stealing_pool pool;
+
+    // Where run_until() starts from, the end of a previous run when resuming it
+    TIME start_time = 0;
+    vector<char> start_changed; // Cells that changed on the day before start_time, all of them when empty
+    bool ran = false;
+
+    // Gives the equations of a cell access to its row
+    struct csr_neighborhood
+    {
+        csr_engine const& engine;
+        unsigned int cell;
+
+        unsigned int size() const { return engine.topology->row_start[cell + 1] - engine.topology->row_start[cell]; }
+        unsigned int self() const { return engine.topology->self_position[cell]; }
+
+        vicinity const& neighbor_vicinity(unsigned int j) const { return engine.topology->vicinities[engine.topology->row_start[cell] + j]; }
+
+        infectious_pressure const& neighbor_pressure(unsigned int j) const
+        {
+            unsigned int neighbor = engine.topology->columns[engine.topology->row_start[cell] + j];
+            if (engine.compact)
+                return engine.page_of(neighbor).pressures[neighbor % page_size];
+
+            return engine.equations_of(cell).infectious_pressure_of(engine.current_state(neighbor));
+        }
+    };
+
+    public:
+        static constexpr unsigned int page_size = 64; // Cells in a page
+
+        csr_engine(string const& scenario_path, unsigned int num_threads, ostream& state_log, ostream& messages_log, bool compact=false) :
+            run_recorder{state_log, messages_log}, compact{compact}, pool{num_threads}
+        {
+            auto cells = make_shared<csr_topology>();
+            cell_registry& registry             = cells->registry;
+            vector<unsigned int>& row_start     = cells->row_start;
+            vector<unsigned int>& columns       = cells->columns;
+            vector<unsigned int>& self_position = cells->self_position;
+
+            vector<unordered_map<string, vicinity>> neighborhoods;
+
+            vector<scenario_cell> loaded;
+            auto add_cell = [&](scenario_cell&& cell) { loaded.push_back(move(cell)); };
+
+            if (compiled_scenario::is_compiled(scenario_path))
+                compiled_scenario::load(scenario_path, add_cell);
+            else
+            {
+                config_store configs;
+                load_scenario(scenario_path, configs, add_cell);
+            }
+
+            // The logs then list the cells in the same order as the Cadmium runner, whatever the order of the file
+            vector<unsigned int> order(loaded.size());
+            iota(order.begin(), order.end(), 0);
+            stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return loaded[a].id < loaded[b].id; });
+
+            for (unsigned int i : order)
+            {
+                scenario_cell& cell = loaded[i];
+                AssertLong(cell.cell_type == "zhong", __FILE__, __LINE__, "Unknown cell type " + cell.cell_type + " for the cell " + cell.id);
+
+                if (registry.size() % page_size == 0)
+                    pages.push_back(make_shared<cell_page>());
+                cell_page& page = *pages.back();
+
+                registry.intern(cell.id);
+                page.equations.emplace_back(cell.state, cell.neighborhood.size(), move(cell.config));
+                page.states[0].push_back(move(cell.state));
+                neighborhoods.push_back(move(cell.neighborhood));
+            }
+            loaded.clear();
+
+            // The neighbors are kept in the order of their unordered_map, like Cadmium does,
+            // so the sums of the equations are done in the same order
+            row_start.push_back(0);
+            for (unsigned int i = 0; i < neighborhoods.size(); ++i)
+            {
+                self_position.push_back(neighborhoods.at(i).size());
+
+                for (auto const& neighbor : neighborhoods.at(i))
+                {
+                    if (neighbor.first == registry.id(i))
+                        self_position.back() = columns.size() - row_start.back();
+
+                    columns.push_back(registry.index(neighbor.first));
+                    cells->vicinities.push_back(neighbor.second);
+                }
+
+                AssertLong(self_position.back() < neighborhoods.at(i).size(), __FILE__, __LINE__,
+                            "The cell " + registry.id(i) + " must be part of its own neighborhood");
+                row_start.push_back(columns.size());
+            }
+
+            topology = move(cells);
+
+            for (shared_ptr<cell_page>& page : pages)
+            {
+                page->states[1] = page->states[0];
+
+                if (compact)
+                {
+                    page->pressures.resize(page->equations.size());
+                    for (unsigned int c = 0; c < page->equations.size(); ++c)
+                        page->equations.at(c).infectious_pressure_of(page->states[0].at(c), page->pressures.at(c));
+                }
+            }
+
+            if (compact)
+                check_compact_messages();
+        }
+
+        csr_engine(csr_engine const&)            = delete;
+        csr_engine& operator=(csr_engine const&) = delete;
+
+        /**
+         * @brief Starts a branch of the simulation where this engine stopped, or from its initial states if it hasn't
+         * run yet. The branch runs on as many threads as this engine and writes its own logs, from the day it starts on.
+         * It shares the neighborhoods and the pages of cells with this engine, see the class comment
+         *
+         * @param state_log Stream to write the state log of the branch to
+         * @param messages_log Stream to write the messages of the branch to
+         * @return unique_ptr<csr_engine>
+        */
+        unique_ptr<csr_engine> fork(ostream& state_log, ostream& messages_log) const
+        {
+            return unique_ptr<csr_engine>(new csr_engine(*this, state_log, messages_log));
+        }
+
+        /**
+         * @brief Number of pages of cells this engine shares with the engine it was forked from or with its forks
+         *
+         * @return unsigned int
+        */
+        unsigned int shared_pages() const
+        {
+            return count_if(pages.begin(), pages.end(), [](shared_ptr<cell_page> const& page) { return page.use_count() > 1; });
+        }
+
+        /**
+         * @brief Changes the rates of some cells from the day the simulation carries on from, for example
+         * to try other vaccination rates. The cells changed transition on that day
+         *
+         * @param change Applied to a copy of each configuration used by the cells changed
+         * @param selected Whether to change the cell of an ID, all of them are changed when empty
+        */
+        void override_config(function<void(simulation_config&)> const& change, function<bool(string const&)> const& selected={})
+        {
+            // The cells sharing a configuration keep sharing the changed one
+            unordered_map<simulation_config const*, shared_ptr<simulation_config const>> changed_configs;
+
+            for (unsigned int i = 0; i < size(); ++i)
+            {
+                if (selected && !selected(topology->registry.id(i)))
+                    continue;
+
+                cell_page& page                 = own_page(i / page_size);
+                geographical_equations& changed = page.equations.at(i % page_size);
+
+                auto changed_config = changed_configs.find(changed.config.get());
+                if (changed_config == changed_configs.end())
+                {
+                    auto config = make_shared<simulation_config>(*changed.config);
+                    change(*config);
+                    changed_config = changed_configs.emplace(changed.config.get(), move(config)).first;
+                }
+
+                changed.use_config(changed_config->second);
+                mark_changed(i);
+
+                // The summary a cell publishes depends on its rates
+                if (compact)
+                    changed.infectious_pressure_of(current_state(i), page.pressures.at(i % page_size));
+            }
+
+            if (compact)
+                check_compact_messages();
+        }
+
+        /**
+         * @brief Changes the states of some cells on the day the simulation carries on from, for example
+         * to try another proportion of disobedient people. The cells changed transition on that day
+         *
+         * @param change Given the ID and the state of each cell, returns whether it changed the state
+        */
+        void override_states(function<bool(string const&, sevirds&)> const& change)
+        {
+            // Changed on a copy so only the pages of the cells changed are copied
+            sevirds changed;
+
+            for (unsigned int i = 0; i < size(); ++i)
+            {
+                changed = current_state(i);
+                if (!change(topology->registry.id(i), changed))
+                    continue;
+
+                changed.update_totals();
+
+                cell_page& page = own_page(i / page_size);
+                unsigned int c  = i % page_size;
+                page.states[now].at(c)     = changed;
+                page.states[1 - now].at(c) = changed;
+                mark_changed(i);
+
+                if (compact)
+                    page.equations.at(c).infectious_pressure_of(changed, page.pressures.at(c));
+            }
+        }
+
+        /**
+         * @brief Carries on a simulation from a checkpoint rather than from the initial states of the scenario.
+         * The logs carry on from where they were when the checkpoint was written, the initial states aren't logged again
+         *
+         * @param saved Checkpoint of a run of the same scenario
+        */
+        void resume(checkpoint const& saved)
+        {
+            saved.check_size(size());
+            for (unsigned int i = 0; i < size(); ++i)
+            {
+                cell_page& page = own_page(i / page_size);
+                unsigned int c  = i % page_size;
+
+                saved.restore(i, topology->registry.id(i), page.states[now].at(c), page.equations.at(c).hysteresis_factors());
+                page.states[1 - now].at(c) = page.states[now].at(c);
+
+                if (compact)
+                    page.equations.at(c).infectious_pressure_of(page.states[now].at(c), page.pressures.at(c));
+            }
+
+            start_time    = saved.time;
+            start_changed = saved.changed;
+            resume_logs(saved);
+        }
+
+        unsigned int size() const { return topology->registry.size(); }
+
+        /**
+         * @brief Runs the simulation until the given time, until no cell changes state anymore
+         * or until the convergence monitor, if any, tells it to stop.
+         * An engine only runs once, fork() it to carry on from where it stopped
+         *
+         * @param until Time at which to stop the simulation
+         * @return TIME Time the simulation stopped at
+        */
+        TIME run_until(TIME until)
+        {
+            AssertLong(!ran, __FILE__, __LINE__, "The engine already ran, fork it to carry on from where it stopped");
+            ran = true;
+
+            cell_registry const& registry         = topology->registry;
+            vector<unsigned int> const& row_start = topology->row_start;
+            vector<unsigned int> const& columns   = topology->columns;
+
+            auto state       = [this](unsigned int i) -> sevirds const& { return current_state(i); };
+            auto saved_state = [this](unsigned int i) { return checkpoint::saved_state(current_state(i), equations_of(i).hysteresis_factors()); };
+
+            vector<string> ids;
+            for (unsigned int i = 0; i < size(); ++i)
+                ids.push_back(registry.id(i));
+            start_run(move(ids), state, start_changed.empty());
+
+            vector<char> changed = start_changed.empty() ? vector<char>(size(), 1) : start_changed;
+            vector<char> next_changed(size());
+            vector<char> active(size());
+
+            TIME time = start_time;
+            for (; time < until; time += 1)
+            {
+                if (find(changed.begin(), changed.end(), 1) == changed.end())
+                    break;
+
+                start_day(time, until);
+
+                pool.parallel_for(size(), [&](unsigned int i) {
+                    active[i]       = 0;
+                    next_changed[i] = 0;
+
+                    for (unsigned int k = row_start[i]; k < row_start[i + 1] && !active[i]; ++k)
+                        active[i] = changed[columns[k]];
+                });
+
+                // Only the pages of the cells that transition or changed yesterday are written to
+                for (unsigned int p = 0; p < pages.size(); ++p)
+                {
+                    unsigned int end = min(size(), (p + 1) * page_size);
+                    for (unsigned int i = p * page_size; i < end; ++i)
+                    {
+                        if (active[i] || changed[i])
+                        {
+                            own_page(p);
+                            break;
+                        }
+                    }
+                }
+
+                pool.parallel_for(size(), [&](unsigned int i) {
+                    if (!active[i] && !changed[i])
+                        return;
+
+                    cell_page& page = *pages[i / page_size];
+                    unsigned int c  = i % page_size;
+
+                    // The other array holds the state from two days ago, it has the shape
+                    // of the cell's states so computing over it doesn't allocate anything
+                    if (active[i])
+                    {
+                        next_changed[i] = page.equations[c].next_state(page.states[now][c], csr_neighborhood{*this, i}, time, page.states[1 - now][c]);
+                        if (next_changed[i])
+                        {
+                            page.equations[c].commit();
+                            return;
+                        }
+                    }
+
+                    // Otherwise the state from two days ago is only different from the current one if the cell
+                    // changed yesterday, the new state may still differ in what operator!= doesn't compare
+                    page.states[1 - now][c] = page.states[now][c];
+                });
+
+                now = 1 - now;
+                swap(changed, next_changed);
+
+                if (compact)
+                {
+                    pool.parallel_for(size(), [&](unsigned int i) {
+                        cell_page& page = *pages[i / page_size];
+                        unsigned int c  = i % page_size;
+
+                        if (changed[i])
+                            page.equations[c].infectious_pressure_of(page.states[now][c], page.pressures[c]);
+                    });
+                }
+
+                if (end_day(time, active, changed, state, pool, saved_state))
+                {
+                    time += 1;
+                    break;
+                }
+            }
+
+            finish_run(state);
+
+            // Where the forks of the engine start from
+            start_time    = time;
+            start_changed = changed;
+            return time;
+        }
+
+    private:
+        // A fork sharing everything but the logs with the engine it is forked from
+        csr_engine(csr_engine const& origin, ostream& state_log, ostream& messages_log) :
+            run_recorder{state_log, messages_log}, topology{origin.topology}, pages{origin.pages}, now{origin.now},
+            compact{origin.compact}, pool{origin.pool.size()}, start_time{origin.start_time}, start_changed{origin.start_changed} { }
+
+        cell_page const& page_of(unsigned int cell) const                   { return *pages[cell / page_size]; }
+        sevirds const& current_state(unsigned int cell) const               { return page_of(cell).states[now][cell % page_size]; }
+        geographical_equations const& equations_of(unsigned int cell) const { return page_of(cell).equations[cell % page_size]; }
+
+        // Copies a page before one of its cells is changed if it's shared, the other engines keep the cells they were forked with
+        cell_page& own_page(unsigned int page)
+        {
+            if (pages.at(page).use_count() > 1)
+                pages.at(page) = make_shared<cell_page>(*pages.at(page));
+
+            return *pages.at(page);
+        }
+
+        // Makes a cell transition on the day the simulation carries on from
+        void mark_changed(unsigned int cell)
+        {
+            if (!start_changed.empty())
+                start_changed.at(cell) = 1;
+        }
+
+        void check_compact_messages() const
+        {
+            for (unsigned int i = 0; i < size(); ++i)
+            {
+                for (unsigned int k = topology->row_start.at(i); k < topology->row_start.at(i + 1); ++k)
+                {
+                    unsigned int neighbor = topology->columns.at(k);
+                    AssertLong(equations_of(i).same_infectious_pressure(equations_of(neighbor)), __FILE__, __LINE__,
+                                "Compact messages need " + topology->registry.id(i) + " and its neighbor " + topology->registry.id(neighbor)
+                                + " to share their mobility and virulence rates");
+                }
+            }
+        }
+}; //class csr_engine{}
+
+#endif //PANDEMIC_HOYA_2002_CSR_ENGINE_HPP
@@ -4,17 +4,38 @@
 #ifndef PANDEMIC_HOYA_2002_ZHONG_COUPLED_HPP
 #define PANDEMIC_HOYA_2002_ZHONG_COUPLED_HPP
 
+#include <algorithm>
+#include <numeric>
 #include <nlohmann/json.hpp>
 #include <cadmium/celldevs/coupled/cells_coupled.hpp>
 #include "cells/geographical_cell.hpp"
+#include "cells/config_store.hpp"
+#include "compiled_scenario.hpp"
 
 using namespace std;
 
 template <typename T>
 class geographical_coupled : public cadmium::celldevs::cells_coupled<T, string, sevirds, vicinity>
 {
+    // Every distinct cell configuration is only parsed once and shared by the cells using it
+    config_store configs;
+
+    // Dense integer indices of the cells, their string IDs are only needed for logging
+    shared_ptr<cell_registry> registry = make_shared<cell_registry>();
+
+    // A standalone coupled model keeps its cells to itself instead of handing them to Cadmium,
+    // they are then run by a parallel_runner
+    bool standalone;
+    vector<shared_ptr<geographical_cell<T>>> standalone_cells;
+
     public:
-        explicit geographical_coupled(string const &id) : cells_coupled<T, string, sevirds, vicinity>(id) { }
+        explicit geographical_coupled(string const &id, bool standalone=false) :
+            cells_coupled<T, string, sevirds, vicinity>(id), standalone{standalone} { }
+
+        shared_ptr<cell_registry const> get_registry() const { return registry; }
+
+        bool is_standalone() const { return standalone; }
+        vector<shared_ptr<geographical_cell<T>>> const& get_standalone_cells() const { return standalone_cells; }
 
         template<typename X>
         using cell_unordered = unordered_map<string, X>;
@@ -24,11 +45,94 @@ class geographical_coupled : public cadmium::celldevs::cells_coupled<T, string,
                             sevirds initial_state,
                             string const& delay_id,
                             nlohmann::json const& config) override
+        {
+            add_geographical_cell(cell_type, cell_id, neighborhood, initial_state, delay_id, configs.get(config));
+        }
+
+        /**
+         * @brief Adds the cells of a scenario converted by the compile-scenario tool
+         *
+         * @param file_path Path to the compiled scenario
+        */
+        void add_cells_compiled(string const& file_path)
+        {
+            add_cells_sorted([&](auto&& add_cell) { compiled_scenario::load(file_path, add_cell); });
+        }
+
+        /**
+         * @brief Adds the cells of a json scenario while it's being parsed, unlike add_cells_json()
+         * which parses the whole scenario first. The cells are still added in the order of their IDs
+         *
+         * @param file_path Path to the scenario json file
+        */
+        void add_cells_streamed(string const& file_path)
+        {
+            add_cells_sorted([&](auto&& add_cell) { load_scenario(file_path, configs, add_cell); });
+        }
+
+        /**
+         * @brief Adds the cells of either a json or a compiled scenario
+         *
+         * @param file_path Path to the scenario
+        */
+        void add_cells_scenario(string const& file_path)
+        {
+            if (compiled_scenario::is_compiled(file_path))
+                add_cells_compiled(file_path);
+            else
+                add_cells_streamed(file_path);
+        }
+
+    private:
+        /**
+         * @brief Adds the cells of a scenario in the order of their IDs, the order add_cells_json() adds them in
+         * as the parsed json sorts its keys. The loggers write the cells in the order they're added, so the logs
+         * don't depend on the order of the file. Standalone cells are built as they're read then sorted, the
+         * others can only be handed to Cadmium once all of them have been read
+         *
+         * @param load Reads the scenario, calling the function it's given with every scenario_cell
+        */
+        template <typename LOAD>
+        void add_cells_sorted(LOAD&& load)
+        {
+            if (standalone)
+            {
+                unsigned int first = standalone_cells.size();
+                load([this](scenario_cell&& cell) { add_scenario_cell(move(cell)); });
+
+                stable_sort(standalone_cells.begin() + first, standalone_cells.end(),
+                            [](shared_ptr<geographical_cell<T>> const& a, shared_ptr<geographical_cell<T>> const& b) { return a->cell_id < b->cell_id; });
+                return;
+            }
+
+            vector<scenario_cell> cells;
+            load([&](scenario_cell&& cell) { cells.push_back(move(cell)); });
+
+            vector<unsigned int> order(cells.size());
+            iota(order.begin(), order.end(), 0);
+            stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return cells[a].id < cells[b].id; });
+
+            for (unsigned int i : order)
+                add_scenario_cell(move(cells[i]));
+        }
+
+        void add_scenario_cell(scenario_cell&& cell)
+        {
+            add_geographical_cell(cell.cell_type, cell.id, cell.neighborhood, cell.state, cell.delay, move(cell.config));
+        }
+
+        void add_geographical_cell(string const& cell_type, string const& cell_id,
+                                    cell_unordered<vicinity> const& neighborhood,
+                                    sevirds const& initial_state,
+                                    string const& delay_id,
+                                    typename geographical_cell<T>::config_type config)
         {
             if (cell_type == "zhong")
             {
-                auto conf = config.get<typename geographical_cell<T>::config_type>();
-                this->template add_cell<geographical_cell>(cell_id, neighborhood, initial_state, delay_id, conf);
+                if (standalone)
+                    standalone_cells.push_back(make_shared<geographical_cell<T>>(cell_id, neighborhood, initial_state, delay_id, move(config), registry));
+                else
+                    this->template add_cell<geographical_cell>(cell_id, neighborhood, initial_state, delay_id, move(config), registry);
             } else throw bad_typeid();
         }
 };
@@ -0,0 +1,161 @@
+#ifndef PANDEMIC_HOYA_2002_LOG_FILTER_HPP
+#define PANDEMIC_HOYA_2002_LOG_FILTER_HPP
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "region_codes.hpp"
+#include "Helpers/Assert.hpp"
+
+using namespace std;
+
+/**
+ * Which days, cells and fields of the states are logged. Everything is logged by default
+*/
+struct log_filter
+{
+    unsigned int every = 1;        // Only log the days that are a multiple of this
+    unordered_set<string> cells;   // IDs of the cells to log, every cell when empty
+    vector<string> field_names;    // Names of every field of the states, the default names when empty
+    vector<string> fields;         // Names of the fields to log, every field when empty
+
+    bool logs_day(double time) const        { return every <= 1 || fmod(time, every) == 0; }
+    bool logs_cell(string const& id) const  { return cells.empty() || cells.count(id) != 0; }
+    bool logs_every_field() const           { return fields.empty(); }
+
+    /**
+     * @brief Names of the fields when no fields.json is given, those of the Ottawa and Ontario scenarios
+     *
+     * @param num_fields Number of fields of the states
+     * @return vector<string>
+    */
+    static vector<string> default_field_names(unsigned int num_fields)
+    {
+        vector<string> names = {"Population", "Susceptible", "Exposed", "VaccinatedD1", "VaccinatedD2", "Infected",
+                                "Recovered", "New Exposed", "New Infected", "New Recovered", "Deaths"};
+
+        unsigned int num_boosters = num_fields > names.size() ? num_fields - names.size() : 0;
+        for (unsigned int i = 1; i <= num_boosters; ++i)
+            names.push_back(num_boosters == 1 ? "VaccinatedB" : "VaccinatedB" + to_string(i));
+
+        return names;
+    }
+
+    /**
+     * @brief Reads the names of the fields from a fields.json
+     *
+     * @param fields_path Path to the fields.json
+    */
+    void read_field_names(string const& fields_path)
+    {
+        ifstream file(fields_path);
+        if (!file.is_open())
+            throw runtime_error{"Unable to open the file: " + fields_path};
+
+        nlohmann::json json;
+        file >> json;
+        json.at("fields").get_to(field_names);
+    }
+
+    /**
+     * @brief Only logs the cells listed in a file, their IDs being separated by spaces, commas or new lines
+     *
+     * @param ids_path Path to the list of IDs
+    */
+    void read_cells(string const& ids_path)
+    {
+        ifstream file(ids_path);
+        if (!file.is_open())
+            throw runtime_error{"Unable to open the file: " + ids_path};
+
+        string id;
+        while (file >> id)
+        {
+            for (string const& part : split_csv_line(id))
+            {
+                if (!part.empty())
+                    cells.insert(part);
+            }
+        }
+    }
+
+    /**
+     * @brief Only logs the cells that are part of the given regions
+     *
+     * @param regions_path Regions file giving the code of each cell, see read_region_codes()
+     * @param codes Codes of the regions to log, such as CSDcodes
+    */
+    void select_regions(string const& regions_path, vector<string> const& codes)
+    {
+        unordered_set<string> selected(codes.begin(), codes.end());
+
+        for (auto const& cell : read_region_codes(regions_path))
+        {
+            if (selected.count(cell.second) != 0)
+                cells.insert(cell.first);
+        }
+    }
+
+    /**
+     * @brief Names of every field of the states
+     *
+     * @param num_fields Number of fields of the states
+     * @return vector<string>
+    */
+    vector<string> all_field_names(unsigned int num_fields) const
+    {
+        vector<string> names = field_names.empty() ? default_field_names(num_fields) : field_names;
+
+        AssertLong(names.size() == num_fields, __FILE__, __LINE__,
+                    "The states have " + to_string(num_fields) + " fields but " + to_string(names.size()) + " are named in fields.json");
+        return names;
+    }
+
+    /**
+     * @brief Positions of the logged fields in the states
+     *
+     * @param num_fields Number of fields of the states
+     * @return vector<unsigned int>
+    */
+    vector<unsigned int> field_indices(unsigned int num_fields) const
+    {
+        vector<string> names = all_field_names(num_fields);
+        vector<unsigned int> indices;
+
+        for (unsigned int i = 0; fields.empty() && i < num_fields; ++i)
+            indices.push_back(i);
+
+        for (string const& field : fields)
+        {
+            auto it = find(names.begin(), names.end(), field);
+            AssertLong(it != names.end(), __FILE__, __LINE__, "Unknown field to log: " + field);
+            indices.push_back(it - names.begin());
+        }
+
+        return indices;
+    }
+}; //struct log_filter{}
+
+/**
+ * @brief Splits a comma separated list given on the command line
+ *
+ * @param list List to split
+ * @return vector<string>
+*/
+vector<string> split_list(string const& list)
+{
+    vector<string> values;
+    for (string const& value : split_csv_line(list))
+    {
+        if (!value.empty())
+            values.push_back(value);
+    }
+
+    return values;
+}
+
+#endif //PANDEMIC_HOYA_2002_LOG_FILTER_HPP
@@ -0,0 +1,211 @@
+#ifndef PANDEMIC_HOYA_2002_PARALLEL_RUNNER_HPP
+#define PANDEMIC_HOYA_2002_PARALLEL_RUNNER_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "geographical_coupled.hpp"
+#include "checkpoint.hpp"
+#include "run_recorder.hpp"
+#include "Helpers/work_stealing_pool.hpp"
+#include "Helpers/Assert.hpp"
+
+using namespace std;
+
+/**
+ * Runs the cells of a standalone geographical_coupled one day at a time, computing every
+ * cell that has to transition on a day concurrently.
+ *
+ * Every cell has an output delay of one day, so the Cadmium runner boils down to: a cell
+ * transitions on day t if itself or one of its neighbors changed state on day t-1, and it
+ * only sees the states its neighbors had at the end of day t-1. Each cell only writes its
+ * own state, so the order the cells are computed in doesn't matter and the logs are
+ * identical to a sequential run. The logs are written by run_recorder in the same format as the Cadmium loggers.
+ *
+ * With compact messages the cells publish an infectious_pressure summary of their state at the end
+ * of each day and their neighbors receive that summary instead of a copy of the whole state.
+*/
+template <typename T>
+class parallel_runner : public run_recorder
+{
+    using cell_type = geographical_cell<T>;
+
+    vector<shared_ptr<cell_type>> cells;           // In the order they were added to the coupled model
+    vector<vector<unsigned int>> neighbor_cells;   // Position in cells of each neighbor, in the same order as neighbors
+    work_stealing_pool pool;
+
+    bool compact;
+    vector<infectious_pressure> pressures; // Published by each cell when using compact messages
+
+    // Where run_until() starts from, the end of a previous run when resuming it
+    T start_time = 0;
+    vector<char> start_changed; // Cells that changed on the day before start_time, all of them when empty
+
+    public:
+        parallel_runner(geographical_coupled<T> const& coupled, unsigned int num_threads, ostream& state_log, ostream& messages_log,
+                        bool compact=false) :
+            run_recorder{state_log, messages_log}, cells{coupled.get_standalone_cells()}, pool{num_threads}, compact{compact}
+        {
+            AssertLong(coupled.is_standalone(), __FILE__, __LINE__, "The parallel runner needs the cells of a standalone geographical_coupled");
+
+            // Translate the interned indices of the neighbors to positions in cells
+            shared_ptr<cell_registry const> registry = coupled.get_registry();
+            vector<unsigned int> position(registry->size(), cells.size());
+            for (unsigned int i = 0; i < cells.size(); ++i)
+                position.at(cells.at(i)->index) = i;
+
+            for (shared_ptr<cell_type> const& cell : cells)
+            {
+                neighbor_cells.emplace_back();
+                for (unsigned int neighbor : cell->neighbor_indices)
+                {
+                    AssertLong(position.at(neighbor) < cells.size(), __FILE__, __LINE__,
+                                "The neighbor " + registry->id(neighbor) + " of " + cell->cell_id + " is not a cell of the scenario");
+                    neighbor_cells.back().push_back(position.at(neighbor));
+                }
+            }
+
+            if (compact)
+            {
+                for (unsigned int i = 0; i < cells.size(); ++i)
+                {
+                    for (unsigned int neighbor : neighbor_cells.at(i))
+                    {
+                        AssertLong(cells.at(i)->same_infectious_pressure(*cells.at(neighbor)), __FILE__, __LINE__,
+                                    "Compact messages need " + cells.at(i)->cell_id + " and its neighbor " + cells.at(neighbor)->cell_id
+                                    + " to share their mobility and virulence rates");
+                    }
+
+                    cells.at(i)->use_compact_messages();
+                }
+
+                pressures.resize(cells.size());
+                for (unsigned int i = 0; i < cells.size(); ++i)
+                    cells.at(i)->infectious_pressure_of(cells.at(i)->state.current_state, pressures.at(i));
+            }
+        }
+
+        /**
+         * @brief Carries on a simulation from a checkpoint rather than from the initial states of the scenario.
+         * The logs carry on from where they were when the checkpoint was written, the initial states aren't logged again
+         *
+         * @param saved Checkpoint of a run of the same scenario
+        */
+        void resume(checkpoint const& saved)
+        {
+            saved.check_size(cells.size());
+            for (unsigned int i = 0; i < cells.size(); ++i)
+                saved.restore(i, cells.at(i)->cell_id, cells.at(i)->state.current_state, cells.at(i)->hysteresis_factors());
+
+            for (unsigned int i = 0; compact && i < cells.size(); ++i)
+                cells.at(i)->infectious_pressure_of(cells.at(i)->state.current_state, pressures.at(i));
+
+            // The cells' copies of their neighbors' states are only refreshed when the neighbors change
+            for (unsigned int i = 0; i < cells.size(); ++i)
+            {
+                cell_type& cell = *cells.at(i);
+                for (unsigned int j = 0; j < neighbor_cells.at(i).size(); ++j)
+                {
+                    unsigned int neighbor = neighbor_cells.at(i).at(j);
+                    if (compact)
+                        cell.neighbor_pressures.at(j) = pressures.at(neighbor);
+                    else
+                        *cell.neighbor_states.at(j) = cells.at(neighbor)->state.current_state;
+                }
+            }
+
+            start_time    = saved.time;
+            start_changed = saved.changed;
+            resume_logs(saved);
+        }
+
+        /**
+         * @brief Runs the simulation until the given time, until no cell changes state anymore
+         * or until the convergence monitor, if any, tells it to stop
+         *
+         * @param until Time at which to stop the simulation
+         * @return T Time the simulation stopped at
+        */
+        T run_until(T until)
+        {
+            auto state       = [this](unsigned int i) -> sevirds const& { return cells[i]->state.current_state; };
+            auto saved_state = [this](unsigned int i) { return checkpoint::saved_state(cells[i]->state.current_state, cells[i]->hysteresis_factors()); };
+
+            vector<string> ids;
+            for (shared_ptr<cell_type> const& cell : cells)
+                ids.push_back(cell->cell_id);
+            start_run(move(ids), state, start_changed.empty());
+
+            vector<char> changed = start_changed.empty() ? vector<char>(cells.size(), 1) : start_changed;
+            vector<char> active(cells.size());
+
+            // The cells compute over these and swap them with their states when they change,
+            // so they always have the shape of the cells' states and nothing is allocated
+            vector<sevirds> next_states(cells.size());
+            for (unsigned int i = 0; i < cells.size(); ++i)
+                next_states[i] = cells[i]->state.current_state;
+
+            T time = start_time;
+            for (; time < until; time += 1)
+            {
+                if (find(changed.begin(), changed.end(), 1) == changed.end())
+                    break;
+
+                start_day(time, until);
+
+                // Hand each cell the states its neighbors ended the previous day with
+                pool.parallel_for(cells.size(), [&](unsigned int i) {
+                    cell_type& cell = *cells[i];
+                    active[i] = 0;
+
+                    for (unsigned int j = 0; j < neighbor_cells[i].size(); ++j)
+                    {
+                        unsigned int neighbor = neighbor_cells[i][j];
+                        if (changed[neighbor])
+                        {
+                            if (compact)
+                                cell.neighbor_pressures[j] = pressures[neighbor];
+                            else
+                                *cell.neighbor_states[j] = cells[neighbor]->state.current_state;
+
+                            active[i] = 1;
+                        }
+                    }
+                });
+
+                // The cells only read their own copies of their neighbors' states so they can all transition at once
+                pool.parallel_for(cells.size(), [&](unsigned int i) {
+                    changed[i] = 0;
+                    if (!active[i])
+                        return;
+
+                    cell_type& cell = *cells[i];
+                    cell.simulation_clock = time;
+
+                    if (cell.local_computation(next_states[i]))
+                    {
+                        swap(cell.state.current_state, next_states[i]);
+                        cell.commit();
+                        changed[i] = 1;
+
+                        if (compact)
+                            cell.infectious_pressure_of(cell.state.current_state, pressures[i]);
+                    }
+                });
+
+                if (end_day(time, active, changed, state, pool, saved_state))
+                {
+                    time += 1;
+                    break;
+                }
+            }
+
+            finish_run(state);
+            return time;
+        }
+}; //class parallel_runner{}
+
+#endif //PANDEMIC_HOYA_2002_PARALLEL_RUNNER_HPP
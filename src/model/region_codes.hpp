@@ -0,0 +1,69 @@
+#ifndef PANDEMIC_HOYA_2002_REGION_CODES_HPP
+#define PANDEMIC_HOYA_2002_REGION_CODES_HPP
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Helpers/Assert.hpp"
+
+using namespace std;
+
+/**
+ * @brief Splits a line of a csv file, the regions files don't quote their values
+ *
+ * @param line Line to split
+ * @return vector<string>
+*/
+vector<string> split_csv_line(string const& line)
+{
+    vector<string> values;
+    stringstream stream(line);
+    string value;
+
+    while (getline(stream, value, ','))
+    {
+        if (!value.empty() && value.back() == '\r')
+            value.pop_back();
+        values.push_back(value);
+    }
+
+    return values;
+}
+
+/**
+ * @brief Reads the code of a larger region each cell is part of, from a regions file
+ * such as cadmium_gis/ottawa/ottawa_dauid_clean.csv. The first column is the ID of the cells
+ *
+ * @param csv_path Path to the regions file
+ * @param column Name of the column holding the codes
+ * @return unordered_map<string, string> Code of each cell
+*/
+unordered_map<string, string> read_region_codes(string const& csv_path, string const& column="CSDcode")
+{
+    ifstream file(csv_path);
+    if (!file.is_open())
+        throw runtime_error{"Unable to open the file: " + csv_path};
+
+    string line;
+    getline(file, line);
+    vector<string> header = split_csv_line(line);
+
+    auto code_column = find(header.begin(), header.end(), column);
+    AssertLong(code_column != header.end(), __FILE__, __LINE__, csv_path + " has no " + column + " column");
+    unsigned int code_index = code_column - header.begin();
+
+    unordered_map<string, string> codes;
+    while (getline(file, line))
+    {
+        vector<string> values = split_csv_line(line);
+        if (values.size() > code_index)
+            codes[values.front()] = values.at(code_index);
+    }
+
+    return codes;
+}
+
+#endif //PANDEMIC_HOYA_2002_REGION_CODES_HPP
@@ -0,0 +1,211 @@
+#ifndef PANDEMIC_HOYA_2002_RUN_RECORDER_HPP
+#define PANDEMIC_HOYA_2002_RUN_RECORDER_HPP
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "aggregate_log.hpp"
+#include "checkpoint.hpp"
+#include "convergence_monitor.hpp"
+#include "state_logger.hpp"
+#include "Helpers/work_stealing_pool.hpp"
+
+using namespace std;
+
+/**
+ * What the runners outside of Cadmium (parallel_runner and csr_engine) do besides computing the cells:
+ * the state and message logs in the format of the Cadmium loggers, the time series, the checkpoints,
+ * the progress meter and the convergence monitor.
+ *
+ * A runner calls start_run() before its first day, start_day() and end_day() around the computation of
+ * every day, then finish_run(). The states of the cells are given by a function of their index.
+*/
+class run_recorder
+{
+    state_logger states;
+    ostream& messages_log;
+    aggregate_log* aggregates = nullptr;
+    convergence_monitor* monitor = nullptr;
+    bool progress = false;
+
+    checkpoint_writer* checkpoints = nullptr;
+    unsigned int checkpoint_every  = 0;
+
+    vector<string> ids; // IDs of the cells, in the order of their indices
+
+    public:
+        run_recorder(ostream& state_log, ostream& messages_log) : states{state_log}, messages_log{messages_log} { }
+
+        void turn_progress_on() { progress = true; }
+
+        /**
+         * @brief Writes the states of the cells to a binary log instead of the text state log
+         *
+         * @param log Log to write to, it is finished at the end of run_until()
+        */
+        void use_binary_state_log(binary_state_log& log) { states.use_binary_state_log(log); }
+
+        /**
+         * @brief Also writes the states of the cells as the structure and messages of the GIS viewer
+         *
+         * @param log Viewer files to write, they are finished at the end of run_until()
+        */
+        void use_viewer_log(viewer_log& log) { states.use_viewer_log(log); }
+
+        /**
+         * @brief Only logs the days, cells and fields of the states kept by a filter, the messages are all logged
+         *
+         * @param filter Filter of the state log
+        */
+        void use_log_filter(log_filter filter) { states.use_filter(move(filter)); }
+
+        /**
+         * @brief Writes the population weighted time series of the simulation as it runs
+         *
+         * @param log Time series to write, they are finished at the end of run_until()
+        */
+        void use_aggregate_log(aggregate_log& log) { aggregates = &log; }
+
+        /**
+         * @brief Stops the simulation before its end time once the epidemic is over
+         *
+         * @param convergence Tells when the epidemic is over
+        */
+        void use_convergence_monitor(convergence_monitor& convergence) { monitor = &convergence; }
+
+        /**
+         * @brief Writes a checkpoint of the simulation every few days
+         *
+         * @param writer Writes the checkpoints
+         * @param every Number of days between checkpoints
+        */
+        void use_checkpoints(checkpoint_writer& writer, unsigned int every)
+        {
+            checkpoints      = &writer;
+            checkpoint_every = every;
+        }
+
+    protected:
+        /**
+         * @brief Carries on the logs of the simulation a checkpoint was written by, to call before start_run()
+         *
+         * @param saved Checkpoint the simulation resumes from
+        */
+        void resume_logs(checkpoint const& saved) { states.resume(saved); }
+
+        /**
+         * @brief Sets everything up from the states the run starts with
+         *
+         * @param cell_ids IDs of the cells, in the order of their indices
+         * @param state Gives the state of the cell at an index
+         * @param initial_states Are the states logged? They aren't when resuming a simulation
+        */
+        template <typename STATE>
+        void start_run(vector<string> cell_ids, STATE const& state, bool initial_states)
+        {
+            ids = move(cell_ids);
+
+            if (aggregates)
+                aggregates->start(ids, state);
+            states.start(ids, state, initial_states);
+            if (monitor)
+                monitor->start(ids.size(), state);
+        }
+
+        template <typename TIME>
+        void start_day(TIME time, TIME until)
+        {
+            if (progress)
+                cout << "\r\033[33mSimulating day " << time << " of " << until << "\033[0m" << flush;
+
+            messages_log << time << "\n";
+        }
+
+        /**
+         * @brief Logs the end of a day, writes a checkpoint when one is due and asks the convergence monitor whether to go on
+         *
+         * @param time Time of the day
+         * @param active Has each cell transitioned on the day?
+         * @param changed Has each cell changed state on the day?
+         * @param state Gives the state of the cell at an index
+         * @param pool Threads the states are copied with for the checkpoint
+         * @param saved_state Gives the checkpoint::saved_state of the cell at an index
+         * @return bool Should the simulation stop?
+        */
+        template <typename TIME, typename STATE, typename SAVED_STATE>
+        bool end_day(TIME time, vector<char> const& active, vector<char> const& changed, STATE const& state,
+                        work_stealing_pool& pool, SAVED_STATE const& saved_state)
+        {
+            states.day(time, active, state);
+            if (aggregates)
+                aggregates->day(time, changed, state);
+
+            for (unsigned int i = 0; i < ids.size(); ++i)
+            {
+                if (changed[i])
+                    messages_log << "[cell_out: {" << state(i) << "}] generated by model _" << ids[i] << "\n";
+            }
+
+            if (checkpoints && fmod(time + 1, checkpoint_every) == 0)
+            {
+                // A resumed simulation cuts the logs down to their sizes in the checkpoint, which
+                // must be on disk before the checkpoint is in case the simulation gets killed
+                flush_logs();
+                checkpoints->write(save(time + 1, changed, pool, saved_state));
+            }
+
+            return monitor && monitor->day(changed, state);
+        }
+
+        /**
+         * @brief Finishes the logs once the run stopped
+         *
+         * @param state Gives the state of the cell at an index
+        */
+        template <typename STATE>
+        void finish_run(STATE const& state)
+        {
+            states.finish(state);
+            messages_log.flush();
+
+            if (aggregates)
+                aggregates->finish();
+            if (checkpoints)
+                checkpoints->wait();
+        }
+
+    private:
+        void flush_logs()
+        {
+            states.flush();
+            messages_log.flush();
+            if (aggregates)
+                aggregates->flush();
+        }
+
+        // Copies what a checkpoint needs, the simulation only waits for this while the checkpoint is written
+        template <typename SAVED_STATE>
+        checkpoint save(double next_time, vector<char> const& changed, work_stealing_pool& pool, SAVED_STATE const& saved_state) const
+        {
+            checkpoint saved;
+            saved.time    = next_time;
+            saved.ids     = ids;
+            saved.changed = changed;
+            saved.states.resize(ids.size());
+
+            pool.parallel_for(ids.size(), [&](unsigned int i) { saved.states[i] = saved_state(i); });
+
+            states.save(saved);
+            saved.log_sizes["messages"] = messages_log.tellp();
+            if (aggregates && aggregates->global_size() >= 0)
+                saved.log_sizes["aggregates"] = aggregates->global_size();
+            if (aggregates && aggregates->groups_size() >= 0)
+                saved.log_sizes["aggregate_regions"] = aggregates->groups_size();
+
+            return saved;
+        }
+}; //class run_recorder{}
+
+#endif //PANDEMIC_HOYA_2002_RUN_RECORDER_HPP
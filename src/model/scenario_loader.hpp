@@ -0,0 +1,134 @@
+#ifndef PANDEMIC_HOYA_2002_SCENARIO_LOADER_HPP
+#define PANDEMIC_HOYA_2002_SCENARIO_LOADER_HPP
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "cells/vicinity.hpp"
+#include "cells/sevirds.hpp"
+#include "cells/config_store.hpp"
+#include "cells/correction_profile_store.hpp"
+
+using namespace std;
+
+/**
+ * A cell of a scenario, with the default cell already applied
+*/
+struct scenario_cell
+{
+    string id;
+    string cell_type;
+    string delay;
+    unordered_map<string, vicinity> neighborhood;
+    sevirds state;
+    shared_ptr<simulation_config const> config;
+};
+
+/**
+ * @brief Builds a cell of a scenario the same way cells_coupled::add_cells_json() does:
+ * the cell is merged over the "default" cell, its own neighborhood replacing the default one
+ *
+ * @param id ID of the cell
+ * @param default_cell The "default" entry of the scenario
+ * @param entry The entry of the cell in the scenario
+ * @param configs Parses the configurations of the cells
+ * @param profiles Parses the correction factors of the vicinities
+ * @return scenario_cell
+*/
+scenario_cell make_scenario_cell(string const& id, nlohmann::json const& default_cell, nlohmann::json const& entry, config_store& configs,
+                                    correction_profile_store& profiles)
+{
+    nlohmann::json cell_json = default_cell;
+    cell_json.merge_patch(entry);
+    if (entry.contains("neighborhood"))
+        cell_json["neighborhood"] = entry.at("neighborhood");
+
+    scenario_cell cell;
+    cell.id           = id;
+    cell.cell_type    = cell_json.at("cell_type").get<string>();
+    cell.delay        = cell_json.at("delay").get<string>();
+    cell.state        = cell_json.at("state").get<sevirds>();
+    cell.config       = configs.get(cell_json.at("config"));
+
+    for (auto const& neighbor : cell_json.at("neighborhood").items())
+    {
+        vicinity& v          = cell.neighborhood[neighbor.key()];
+        v.correlation        = neighbor.value().at("correlation").get<double>();
+        v.correction_factors = profiles.get(neighbor.value().at("infection_correction_factors"));
+    }
+
+    return cell;
+} //make_scenario_cell()
+
+/**
+ * @brief Reads the cells of a scenario without Cadmium, handing out each cell as soon as its
+ * entry has been parsed. Only the entry being parsed and the "default" cell are held in memory
+ * rather than the whole scenario, so the memory used doesn't grow with the size of the file.
+ * The cells are handed out in the order of the file; cells found before the "default" cell
+ * have to wait for it and are the only ones kept around.
+ * The optional "correction_profiles" of the scenario have to come before the cells using them
+ *
+ * @param file_path Path to the scenario json file
+ * @param configs Parses the configurations of the cells
+ * @param add_cell Called with every scenario_cell of the scenario
+*/
+template <typename ADD_CELL>
+void load_scenario(string const& file_path, config_store& configs, ADD_CELL&& add_cell)
+{
+    ifstream file(file_path);
+    if (!file.is_open())
+        throw runtime_error{"Unable to open the file: " + file_path};
+
+    using parse_event = nlohmann::json::parse_event_t;
+
+    string section;  // Key of the top level object being parsed
+    string cell_id;  // Key of the cell being parsed
+    nlohmann::json default_cell;
+    bool has_default = false;
+    vector<pair<string, nlohmann::json>> waiting; // Cells found before the default one
+    correction_profile_store profiles;
+
+    // Depth 1 holds the keys of the scenario and depth 2 the keys of its "cells" object.
+    // What's left of the scenario once parsed is everything but its cells
+    nlohmann::json scenario = nlohmann::json::parse(file, [&](int depth, parse_event event, nlohmann::json& parsed) {
+        if (depth == 1 && event == parse_event::key)
+            section = parsed.get<string>();
+        else if (depth == 1 && section == "correction_profiles" && event == parse_event::object_end)
+        {
+            profiles.add_named(parsed);
+            return false;
+        }
+        else if (depth == 2 && section == "cells")
+        {
+            if (event == parse_event::key)
+                cell_id = parsed.get<string>();
+            else if (event == parse_event::object_end)
+            {
+                if (cell_id == "default")
+                {
+                    default_cell = move(parsed);
+                    has_default  = true;
+
+                    for (auto const& cell : waiting)
+                        add_cell(make_scenario_cell(cell.first, default_cell, cell.second, configs, profiles));
+                    waiting.clear();
+                }
+                else if (has_default)
+                    add_cell(make_scenario_cell(cell_id, default_cell, parsed, configs, profiles));
+                else
+                    waiting.emplace_back(cell_id, move(parsed));
+
+                return false; // The cell is done with, don't keep it in the parsed scenario
+            }
+        }
+
+        return true;
+    });
+
+    AssertLong(has_default, __FILE__, __LINE__, "The scenario " + file_path + " needs a \"default\" cell");
+} //load_scenario()
+
+#endif //PANDEMIC_HOYA_2002_SCENARIO_LOADER_HPP
@@ -0,0 +1,409 @@
+#ifndef PANDEMIC_HOYA_2002_SIMULATION_OPTIONS_HPP
+#define PANDEMIC_HOYA_2002_SIMULATION_OPTIONS_HPP
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "aggregate_log.hpp"
+#include "binary_state_log.hpp"
+#include "checkpoint.hpp"
+#include "convergence_monitor.hpp"
+#include "log_filter.hpp"
+#include "region_codes.hpp"
+#include "viewer_log.hpp"
+#include "Helpers/async_log_stream.hpp"
+
+using namespace std;
+
+/**
+ * Command line shared by the simulators (main.cpp and main_csr.cpp):
+ *   SCENARIO_CONFIG.json|SCENARIO.bin [MAX_SIMULATION_TIME] [options]
+ * The options that only the runners outside of Cadmium support are refused by check_cadmium_runner(),
+ * those the branches of a simulation don't support by check_branches().
+*/
+struct simulation_options
+{
+    string scenario_path;
+    float sim_time = 500;
+
+    // Has the 'no progress' flag been set?
+    bool no_progress = false;
+
+    // Number of threads computing the cells, 0 when --threads isn't given
+    unsigned int threads = 0;
+
+    // Do the cells send a summary of their state to their neighbors instead of the whole state?
+    bool compact = false;
+
+    // Binary state log written instead of the text one, along with the names of its fields
+    string binary_log_path, fields_path;
+    bool binary_log_float = false;
+
+    // Directory to write the structure.json and messages.log of the GIS viewer in
+    string viewer_log_path;
+
+    // Days, cells and fields of the state log, the cells can be chosen from a list or by CSDcode
+    log_filter filter;
+    string log_cells_path, regions_path;
+    vector<string> log_csd;
+
+    // Population weighted time series of the whole scenario and of each CSDcode of the regions file
+    string aggregates_path, aggregate_regions_path;
+
+    // Are the logs written by background threads?
+    bool async_log = false;
+
+    // Checkpoints written every few days, and the one to carry on from
+    string checkpoint_path, resume_path;
+    unsigned int checkpoint_every = 30;
+
+    // What-if branches the simulation is forked into, see branch_spec.hpp. Only the CSR engine runs them
+    string branches_path;
+
+    // Stops the simulation once the epidemic is extinct or the proportions don't move anymore
+    convergence_monitor convergence;
+    unsigned int extinction_days = 0, steady_days = 0;
+    double extinction_threshold = -1, steady_tolerance = -1;
+
+    /**
+     * @brief Reads the arguments of a simulator and the files they point to
+     *
+     * @param argc Number of arguments, the name of the program included
+     * @param argv Arguments
+    */
+    simulation_options(int argc, char** argv)
+    {
+        if (argc < 2)
+        {
+            cerr << "\033[31mProgram used with wrong parameters. The program must be invoked as follows: "
+                << argv[0] << " SCENARIO_CONFIG.json|SCENARIO.bin [MAX_SIMULATION_TIME (default: 500)] [-np] [--threads N] [--compact] [--async-log] [--binary-log LOG.bin [--binary-log-float]] [--fields FIELDS.json] [--viewer-log DIR] [--log-every N] [--log-cells IDS.txt] [--log-csd CODES --regions REGIONS.csv] [--log-fields NAMES] [--aggregates SERIES.csv] [--aggregate-regions SERIES.csv --regions REGIONS.csv] [--checkpoint CHECKPOINT.bin [--checkpoint-every DAYS]] [--resume CHECKPOINT.bin] [--branches BRANCHES.json] [--stop-on-extinction DAYS [--extinction-threshold P]] [--stop-on-steady-state DAYS [--steady-state-tolerance P]]\33[0m" << endl;
+            throw;
+        }
+
+        // The C++ standard filesystem library is not used as it may require an additional linker flag (-std=c++17),
+        // but more importantly that in certain versions of GCC the filesystem is contained in an experimental folder (GCC 7).
+        // Newer versions of GCC doesn't have this problem (apparently GCC 8+ ?). As a result, depending on the version of GCC
+        // used different code is required, so an older version of code to try to open a file is used.
+
+        // A check to see if the file exists / can be accessed because the error message the JSON library gives if the
+        // file does not exist is not informative (at the time of this writing).
+        scenario_path = argv[1];
+        ifstream file_existence_checker{scenario_path};
+
+        if (!file_existence_checker.is_open())
+            throw runtime_error{"Unable to open the file: " + scenario_path};
+
+        if (argc > 2)
+            sim_time = atof(argv[2]);
+
+        for (int i = 3; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "--threads") == 0)
+            {
+                if (i + 1 >= argc || atoi(argv[i + 1]) < 1)
+                    throw runtime_error{"--threads must be followed by a number of threads greater than 0"};
+
+                threads = atoi(argv[++i]);
+            }
+            else if (strcmp(argv[i], "-np") == 0)
+                no_progress = true;
+            else if (strcmp(argv[i], "--compact") == 0)
+                compact = true;
+            else if (strcmp(argv[i], "--binary-log") == 0 || strcmp(argv[i], "--fields") == 0)
+            {
+                if (i + 1 >= argc)
+                    throw runtime_error{string{argv[i]} + " must be followed by a path"};
+
+                if (strcmp(argv[i], "--binary-log") == 0)
+                    binary_log_path = argv[++i];
+                else
+                    fields_path = argv[++i];
+            }
+            else if (strcmp(argv[i], "--viewer-log") == 0)
+            {
+                if (i + 1 >= argc)
+                    throw runtime_error{"--viewer-log must be followed by a directory"};
+
+                viewer_log_path = argv[++i];
+            }
+            else if (strcmp(argv[i], "--log-every") == 0)
+            {
+                if (i + 1 >= argc || atoi(argv[i + 1]) < 1)
+                    throw runtime_error{"--log-every must be followed by a number of days greater than 0"};
+
+                filter.every = atoi(argv[++i]);
+            }
+            else if (strcmp(argv[i], "--log-cells") == 0 || strcmp(argv[i], "--regions") == 0)
+            {
+                if (i + 1 >= argc)
+                    throw runtime_error{string{argv[i]} + " must be followed by a path"};
+
+                if (strcmp(argv[i], "--log-cells") == 0)
+                    log_cells_path = argv[++i];
+                else
+                    regions_path = argv[++i];
+            }
+            else if (strcmp(argv[i], "--aggregates") == 0 || strcmp(argv[i], "--aggregate-regions") == 0)
+            {
+                if (i + 1 >= argc)
+                    throw runtime_error{string{argv[i]} + " must be followed by a path"};
+
+                if (strcmp(argv[i], "--aggregates") == 0)
+                    aggregates_path = argv[++i];
+                else
+                    aggregate_regions_path = argv[++i];
+            }
+            else if (strcmp(argv[i], "--log-csd") == 0 || strcmp(argv[i], "--log-fields") == 0)
+            {
+                if (i + 1 >= argc)
+                    throw runtime_error{string{argv[i]} + " must be followed by a comma separated list"};
+
+                if (strcmp(argv[i], "--log-csd") == 0)
+                    log_csd = split_list(argv[++i]);
+                else
+                    filter.fields = split_list(argv[++i]);
+            }
+            else if (strcmp(argv[i], "--binary-log-float") == 0)
+                binary_log_float = true;
+            else if (strcmp(argv[i], "--async-log") == 0)
+                async_log = true;
+            else if (strcmp(argv[i], "--checkpoint") == 0 || strcmp(argv[i], "--resume") == 0)
+            {
+                if (i + 1 >= argc)
+                    throw runtime_error{string{argv[i]} + " must be followed by a path"};
+
+                if (strcmp(argv[i], "--checkpoint") == 0)
+                    checkpoint_path = argv[++i];
+                else
+                    resume_path = argv[++i];
+            }
+            else if (strcmp(argv[i], "--branches") == 0)
+            {
+                if (i + 1 >= argc)
+                    throw runtime_error{"--branches must be followed by a path"};
+
+                branches_path = argv[++i];
+            }
+            else if (strcmp(argv[i], "--checkpoint-every") == 0)
+            {
+                if (i + 1 >= argc || atoi(argv[i + 1]) < 1)
+                    throw runtime_error{"--checkpoint-every must be followed by a number of days greater than 0"};
+
+                checkpoint_every = atoi(argv[++i]);
+            }
+            else if (strcmp(argv[i], "--stop-on-extinction") == 0 || strcmp(argv[i], "--stop-on-steady-state") == 0)
+            {
+                if (i + 1 >= argc || atoi(argv[i + 1]) < 1)
+                    throw runtime_error{string{argv[i]} + " must be followed by a number of days greater than 0"};
+
+                if (strcmp(argv[i], "--stop-on-extinction") == 0)
+                    extinction_days = atoi(argv[++i]);
+                else
+                    steady_days = atoi(argv[++i]);
+            }
+            else if (strcmp(argv[i], "--extinction-threshold") == 0 || strcmp(argv[i], "--steady-state-tolerance") == 0)
+            {
+                if (i + 1 >= argc || atof(argv[i + 1]) < 0)
+                    throw runtime_error{string{argv[i]} + " must be followed by a proportion of at least 0"};
+
+                if (strcmp(argv[i], "--extinction-threshold") == 0)
+                    extinction_threshold = atof(argv[++i]);
+                else
+                    steady_tolerance = atof(argv[++i]);
+            }
+        }
+
+        if (!log_csd.empty() && regions_path.empty())
+            throw runtime_error{"--log-csd needs --regions, the file giving the CSDcode of each cell"};
+
+        if (!aggregate_regions_path.empty() && regions_path.empty())
+            throw runtime_error{"--aggregate-regions needs --regions, the file giving the CSDcode of each cell"};
+
+        if (extinction_days > 0)
+            convergence.stop_on_extinction(extinction_days, extinction_threshold);
+        if (steady_days > 0)
+            convergence.stop_on_steady_state(steady_days, steady_tolerance);
+
+        if (!fields_path.empty())
+            filter.read_field_names(fields_path);
+        if (!log_cells_path.empty())
+            filter.read_cells(log_cells_path);
+        if (!log_csd.empty())
+            filter.select_regions(regions_path, log_csd);
+    }
+
+    /**
+     * @brief Refuses the options only the runners outside of Cadmium support, for when the Cadmium runner is used
+    */
+    void check_cadmium_runner() const
+    {
+        if (compact)
+            throw runtime_error{"--compact needs --threads, the messages of the Cadmium runner are the whole state of the cells"};
+
+        if (!binary_log_path.empty())
+            throw runtime_error{"--binary-log needs --threads, the Cadmium loggers only write text"};
+
+        if (!checkpoint_path.empty() || !resume_path.empty())
+            throw runtime_error{"--checkpoint and --resume need --threads, the state of the Cadmium runner can't be saved"};
+
+        if (!viewer_log_path.empty())
+            throw runtime_error{"--viewer-log needs --threads, the Cadmium loggers only write their own logs"};
+
+        if (filter.every > 1 || !log_cells_path.empty() || !log_csd.empty() || !filter.fields.empty())
+            throw runtime_error{"Filtering the state log needs --threads, the Cadmium loggers log every state"};
+
+        if (!aggregates_path.empty() || !aggregate_regions_path.empty())
+            throw runtime_error{"--aggregates and --aggregate-regions need --threads, the Cadmium runner only writes its loggers"};
+
+        if (extinction_days > 0 || steady_days > 0)
+            throw runtime_error{"--stop-on-extinction and --stop-on-steady-state need --threads, the Cadmium runner always runs until the end time"};
+
+        check_parallel_runner();
+    }
+
+    /**
+     * @brief Refuses the options only the CSR engine supports, for when the Cadmium runner or the parallel runner is used
+    */
+    void check_parallel_runner() const
+    {
+        if (!branches_path.empty())
+            throw runtime_error{"--branches needs the CSR engine (pandemic-geographical_model-csr), the other runners can't be forked"};
+    }
+
+    /**
+     * @brief Refuses the options that would only cover the simulation until the fork day, for when it's forked into --branches.
+     * The branches only write their own text logs
+    */
+    void check_branches() const
+    {
+        if (branches_path.empty())
+            return;
+
+        if (!binary_log_path.empty() || !viewer_log_path.empty())
+            throw runtime_error{"--binary-log and --viewer-log can't be given with --branches, the branches only write text logs"};
+
+        if (filter.every > 1 || !log_cells_path.empty() || !log_csd.empty() || !filter.fields.empty())
+            throw runtime_error{"Filtering the state log can't be done with --branches, the branches log every state"};
+
+        if (!aggregates_path.empty() || !aggregate_regions_path.empty())
+            throw runtime_error{"--aggregates and --aggregate-regions can't be given with --branches, the branches don't write time series"};
+
+        if (!checkpoint_path.empty())
+            throw runtime_error{"--checkpoint can't be given with --branches, the branches can't be saved"};
+
+        if (extinction_days > 0 || steady_days > 0)
+            throw runtime_error{"--stop-on-extinction and --stop-on-steady-state can't be given with --branches, the branches run until the end time"};
+    }
+}; //struct simulation_options{}
+
+/**
+ * The logs, time series and checkpoints asked for by the options of a simulation, open until it's done.
+ * The text logs are opened right away as the Cadmium loggers write to them too; the rest is only
+ * opened when handed to a runner outside of Cadmium by attach().
+ *
+ * A resumed simulation carries every log on from the size it had when the checkpoint was written,
+ * what the previous run logged after it is dropped as those days are simulated again.
+*/
+class simulation_outputs
+{
+    ofstream out_messages;
+    ofstream out_state;
+
+    // With --async-log the text logs are written by background threads instead
+    unique_ptr<async_log_stream> async_messages, async_state;
+
+    unique_ptr<binary_state_log> binary_log;
+    unique_ptr<viewer_log> viewer;
+    unique_ptr<aggregate_log> aggregates;
+    unique_ptr<checkpoint_writer> checkpoints;
+
+    unique_ptr<checkpoint> resumed; // Read before opening the logs, they are cut down to it
+
+    public:
+        explicit simulation_outputs(simulation_options const& options)
+        {
+            if (!options.resume_path.empty())
+                resumed = make_unique<checkpoint>(checkpoint::read(options.resume_path));
+
+            open_continued(out_messages, "../logs/pandemic_messages.txt", kept("messages", "--resume"));
+            open_continued(out_state, "../logs/pandemic_state.txt", kept("state", "--resume"));
+
+            if (options.async_log)
+            {
+                async_messages = make_unique<async_log_stream>(out_messages);
+                async_state    = make_unique<async_log_stream>(out_state);
+            }
+        }
+
+        simulation_outputs(simulation_outputs const&)            = delete;
+        simulation_outputs& operator=(simulation_outputs const&) = delete;
+
+        ostream& messages_log() { return async_messages ? *async_messages : static_cast<ostream&>(out_messages); }
+        ostream& state_log()    { return async_state ? *async_state : static_cast<ostream&>(out_state); }
+
+        /**
+         * @brief Hands the outputs and the options of the simulation to a runner outside of Cadmium,
+         * and carries on from the checkpoint to resume, if any
+         *
+         * @param runner parallel_runner or csr_engine
+         * @param options Options of the simulation, its log filter is moved to the runner
+        */
+        template <typename RUNNER>
+        void attach(RUNNER& runner, simulation_options& options)
+        {
+            if (!options.binary_log_path.empty())
+            {
+                if (resumed)
+                    binary_log = make_unique<binary_state_log>(options.binary_log_path, options.binary_log_float,
+                                                                resumed->binary_log_days, kept("binary_log", "--binary-log"));
+                else
+                    binary_log = make_unique<binary_state_log>(options.binary_log_path, options.binary_log_float);
+                runner.use_binary_state_log(*binary_log);
+            }
+            if (!options.viewer_log_path.empty())
+            {
+                viewer = make_unique<viewer_log>(options.viewer_log_path, kept("viewer", "--viewer-log"));
+                runner.use_viewer_log(*viewer);
+            }
+            runner.use_log_filter(move(options.filter));
+
+            if (!options.aggregates_path.empty() || !options.aggregate_regions_path.empty())
+            {
+                aggregates = make_unique<aggregate_log>(options.aggregates_path,
+                                                        options.aggregates_path.empty() ? -1 : kept("aggregates", "--aggregates"));
+                if (!options.aggregate_regions_path.empty())
+                    aggregates->group_by(options.aggregate_regions_path, read_region_codes(options.regions_path), "CSDcode",
+                                            kept("aggregate_regions", "--aggregate-regions"));
+                runner.use_aggregate_log(*aggregates);
+            }
+
+            if (!options.checkpoint_path.empty())
+            {
+                checkpoints = make_unique<checkpoint_writer>(options.checkpoint_path);
+                runner.use_checkpoints(*checkpoints, options.checkpoint_every);
+            }
+
+            if (options.convergence.enabled())
+                runner.use_convergence_monitor(options.convergence);
+
+            if (resumed)
+                runner.resume(*resumed);
+
+            // Turn on the progress meter
+            if (!options.no_progress)
+                runner.turn_progress_on();
+        }
+
+    private:
+        // Size of a log when the checkpoint resumed was written, -1 when the simulation isn't resumed
+        streamoff kept(string const& log, string const& option) const
+        {
+            return resumed ? resumed->log_size(log, option) : -1;
+        }
+}; //class simulation_outputs{}
+
+#endif //PANDEMIC_HOYA_2002_SIMULATION_OPTIONS_HPP
@@ -0,0 +1,269 @@
+#ifndef PANDEMIC_HOYA_2002_STATE_LOGGER_HPP
+#define PANDEMIC_HOYA_2002_STATE_LOGGER_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "binary_state_log.hpp"
+#include "checkpoint.hpp"
+#include "log_filter.hpp"
+#include "viewer_log.hpp"
+#include "cells/sevirds.hpp"
+#include "Helpers/chars_writer.hpp"
+
+using namespace std;
+
+/**
+ * Writes the states of the cells of the runners that don't go through Cadmium, in the format
+ * of the Cadmium state logger or to a binary_state_log, and along with them the messages of the GIS viewer.
+ *
+ * A log_filter can restrict the days, cells and fields logged; what isn't logged is never computed
+ * nor formatted. When days are skipped, a logged day holds every cell that transitioned since the
+ * last logged day, and the last day simulated is logged with those left when the simulation ends,
+ * so the log still ends with the latest state of every cell.
+*/
+class state_logger
+{
+    ostream& state_log;
+    binary_state_log* binary_log = nullptr; // Replaces the text state log when set
+    viewer_log* viewer = nullptr;
+    log_filter filter;
+
+    vector<string> ids;
+    vector<char> logged_cells;          // Does the filter keep the cell?
+    vector<char> pending;               // Has the cell transitioned since the last logged day?
+    vector<unsigned int> field_indices; // Fields kept by the filter
+    vector<double> all_values;          // Every field of the state being logged
+    vector<double> values;              // The fields of it that are logged
+    double last_time = 0;               // Time of the last day simulated
+
+    public:
+        explicit state_logger(ostream& state_log) : state_log{state_log} { }
+
+        /**
+         * @brief Writes the states to a binary log instead of the text state log
+         *
+         * @param log Log to write to, it is finished along with the simulation
+        */
+        void use_binary_state_log(binary_state_log& log) { binary_log = &log; }
+
+        /**
+         * @brief Also writes the states as the messages of the GIS viewer
+         *
+         * @param log Viewer files to write, they are finished along with the simulation
+        */
+        void use_viewer_log(viewer_log& log) { viewer = &log; }
+
+        void use_filter(log_filter new_filter) { filter = move(new_filter); }
+
+        /**
+         * @brief Carries on the logs of the simulation a checkpoint was written by, to call before start()
+         *
+         * @param saved Checkpoint of the end of the last logged day
+        */
+        void resume(checkpoint const& saved)
+        {
+            pending   = saved.log_pending;
+            last_time = saved.time - 1;
+        }
+
+        /**
+         * @brief Writes everything logged so far to the files, for a checkpoint to find it there
+        */
+        void flush()
+        {
+            state_log.flush();
+            if (binary_log)
+                binary_log->flush();
+            if (viewer)
+                viewer->flush();
+        }
+
+        /**
+         * @brief Saves where the logs are in a checkpoint of the end of the current day
+         *
+         * @param saved Checkpoint being written
+        */
+        void save(checkpoint& saved) const
+        {
+            saved.log_sizes["state"] = state_log.tellp();
+            saved.log_pending        = pending;
+
+            if (binary_log)
+            {
+                saved.log_sizes["binary_log"] = binary_log->size();
+                saved.binary_log_days         = binary_log->logged_days();
+            }
+            if (viewer)
+                saved.log_sizes["viewer"] = viewer->size();
+        }
+
+        /**
+         * @brief Logs the initial states of the cells and sets the log up
+         *
+         * @param cell_ids IDs of the cells, in the order of their indices
+         * @param state Gives the state of the cell at an index
+         * @param initial_states Are the states logged? They aren't when resuming a simulation
+        */
+        template <typename STATE>
+        void start(vector<string> cell_ids, STATE&& state, bool initial_states=true)
+        {
+            ids = move(cell_ids);
+            logged_cells.assign(ids.size(), 0);
+            pending.resize(ids.size(), 0); // Those of a resumed simulation are kept
+
+            for (unsigned int i = 0; i < ids.size(); ++i)
+                logged_cells[i] = filter.logs_cell(ids[i]);
+
+            unsigned int num_fields = 0;
+            if (!ids.empty())
+                visit_fields(state(0), [&](double) { ++num_fields; });
+
+            field_indices = filter.field_indices(num_fields);
+
+            if (binary_log || viewer)
+            {
+                vector<string> all_names = filter.all_field_names(num_fields);
+                vector<string> names;
+                for (unsigned int index : field_indices)
+                    names.push_back(all_names.at(index));
+
+                if (viewer)
+                    viewer->start(ids, names);
+                if (binary_log)
+                    binary_log->start(ids, move(names));
+            }
+
+            for (unsigned int i = 0; initial_states && i < ids.size(); ++i)
+            {
+                if (logged_cells[i])
+                    log_state(i, state(i));
+            }
+
+            if (binary_log)
+                binary_log->end_day();
+        }
+
+        /**
+         * @brief Logs the states of the cells that transitioned on a day, if the day is logged
+         *
+         * @param time Time of the day
+         * @param active Has each cell transitioned on the day?
+         * @param state Gives the state of the cell at an index
+        */
+        template <typename TIME, typename STATE>
+        void day(TIME time, vector<char> const& active, STATE&& state)
+        {
+            last_time = time;
+
+            for (unsigned int i = 0; i < ids.size(); ++i)
+                pending[i] = pending[i] || (active[i] && logged_cells[i]);
+
+            if (filter.logs_day(time))
+                log_pending(time, state);
+        }
+
+        /**
+         * @brief Logs the last day simulated if some cells transitioned since the last logged day, then finishes the logs
+         *
+         * @param state Gives the state of the cell at an index
+        */
+        template <typename STATE>
+        void finish(STATE&& state)
+        {
+            if (find(pending.begin(), pending.end(), 1) != pending.end())
+                log_pending(last_time, state);
+
+            if (binary_log)
+                binary_log->finish();
+            if (viewer)
+                viewer->finish();
+
+            state_log.flush();
+        }
+
+    private:
+        // Logs a day with the states of the cells that transitioned since the last logged day
+        template <typename STATE>
+        void log_pending(double time, STATE&& state)
+        {
+            if (binary_log)
+                binary_log->day(time);
+            else
+                state_log << time << "\n";
+
+            if (viewer)
+                viewer->day(time);
+
+            for (unsigned int i = 0; i < ids.size(); ++i)
+            {
+                if (pending[i])
+                {
+                    log_state(i, state(i));
+                    pending[i] = 0;
+                }
+            }
+
+            if (binary_log)
+                binary_log->end_day();
+        }
+
+        void log_state(unsigned int cell, sevirds const& state)
+        {
+            // Without a field filter the text log is written exactly like the Cadmium logger does
+            bool whole_state = !binary_log && filter.logs_every_field();
+            if (whole_state)
+                state_log << "State for model _" << ids[cell] << " is " << state << "\n";
+
+            if (whole_state && !viewer)
+                return;
+
+            all_values.clear();
+            visit_fields(state, [this](double value) { all_values.push_back(value); });
+
+            values.clear();
+            for (unsigned int index : field_indices)
+                values.push_back(all_values.at(index));
+
+            if (viewer)
+                viewer->state(cell, values);
+
+            if (binary_log)
+                binary_log->state(cell, values);
+            else if (!whole_state)
+            {
+                state_log << "State for model _" << ids[cell] << " is ";
+                write_values(state_log, values);
+                state_log << "\n";
+            }
+        }
+
+        // Writes values the way operator<<(ostream&, sevirds) does
+        static void write_values(ostream& os, vector<double> const& values)
+        {
+            char separator = '<';
+
+            if (chars_writer::formats_like(os))
+            {
+                chars_writer out(os);
+                for (double value : values)
+                {
+                    out.put(separator);
+                    out.put(value, os.precision());
+                    separator = ',';
+                }
+                out.put('>');
+                return;
+            }
+
+            for (double value : values)
+            {
+                os << separator << value;
+                separator = ',';
+            }
+            os << ">";
+        }
+}; //class state_logger{}
+
+#endif //PANDEMIC_HOYA_2002_STATE_LOGGER_HPP
@@ -0,0 +1,139 @@
+#ifndef PANDEMIC_HOYA_2002_VIEWER_LOG_HPP
+#define PANDEMIC_HOYA_2002_VIEWER_LOG_HPP
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "Helpers/binary_io.hpp"
+#include "Helpers/chars_writer.hpp"
+#include "Helpers/Assert.hpp"
+
+using namespace std;
+
+/**
+ * Writes the structure.json and messages.log of the GIS viewer while the simulation runs,
+ * the files Scripts/Msg_Log_Parser/main.py makes out of the scenario and the state log.
+ *
+ * The components of the structure are the top model followed by the cells in the order of their indices,
+ * so the messages are written with the index of the cell plus one instead of looking its ID up.
+*/
+class viewer_log
+{
+    string directory;
+    ofstream messages;
+    bool finished = false;
+
+    public:
+        /**
+         * @param directory Existing directory to write structure.json and messages.log in
+         * @param kept Size of the messages.log of a previous run to carry on from, it is started over when negative
+        */
+        explicit viewer_log(string directory, streamoff kept=-1) : directory{move(directory)}
+        {
+            open_continued(messages, this->directory + "/messages.log", kept);
+            if (!messages.is_open())
+                throw runtime_error{"Unable to open the file: " + this->directory + "/messages.log"};
+        }
+
+        ~viewer_log() { finish(); }
+
+        viewer_log(viewer_log const&)            = delete;
+        viewer_log& operator=(viewer_log const&) = delete;
+
+        /**
+         * @brief Writes structure.json, the states that follow are the initial ones
+         *
+         * @param ids IDs of the cells, in the order of the cell indices given to state()
+         * @param field_names Names of the fields of the states, the template of their messages
+        */
+        void start(vector<string> const& ids, vector<string> const& field_names)
+        {
+            string path = directory + "/structure.json";
+            ofstream structure(path);
+            if (!structure.is_open())
+                throw runtime_error{"Unable to open the file: " + path};
+
+            // Written the way python's json.dump() writes what main.py builds
+            structure << R"({"formalism": "GIS-DEVS", "simulator": "Cadmium", "top": 0, "components": [{"id": "top", "model_type": 0})";
+            for (string const& id : ids)
+                structure << R"(, {"id": )" << quoted(id) << R"(, "model_type": 1})";
+
+            structure << R"(], "model_types": [{"id": 0, "components": [)";
+            for (unsigned int i = 1; i <= ids.size(); ++i)
+                structure << (i > 1 ? ", " : "") << i;
+
+            structure << R"(], "couplings": [], "name": "top", "ports": [], "type": "top"}, )"
+                      << R"({"id": 1, "message_type": 0, "name": "cell", "ports": [], "type": "atomic"}], )"
+                      << R"("message_types": [{"description": "No description available.", "id": 0, "name": "s_model", "template": [)";
+            for (unsigned int i = 0; i < field_names.size(); ++i)
+                structure << (i > 0 ? ", " : "") << quoted(field_names[i]);
+            structure << "]}]}";
+
+            structure.close();
+            AssertLong(!structure.fail(), __FILE__, __LINE__, "Unable to write the viewer structure " + path);
+        }
+
+        /**
+         * @brief Starts a new day, the states that follow are the ones the cells have at its end
+         *
+         * @param time Time of the day
+        */
+        template <typename TIME>
+        void day(TIME time) { messages << time << "\n"; }
+
+        /**
+         * @brief Writes the message of the state of a cell
+         *
+         * @param cell Index of the cell
+         * @param values Value of each field of the state of the cell
+        */
+        void state(unsigned int cell, vector<double> const& values)
+        {
+            if (!chars_writer::formats_like(messages))
+            {
+                messages << cell + 1 << ";";
+                for (unsigned int i = 0; i < values.size(); ++i)
+                    messages << (i > 0 ? "," : "") << values[i];
+                messages << "\n";
+                return;
+            }
+
+            chars_writer out(messages);
+            out.put(static_cast<unsigned long>(cell) + 1);
+            out.put(';');
+            for (unsigned int i = 0; i < values.size(); ++i)
+            {
+                if (i > 0)
+                    out.put(',');
+                out.put(values[i], messages.precision());
+            }
+            out.put('\n');
+        }
+
+        /**
+         * @brief Writes the states logged so far to messages.log
+        */
+        void flush() { messages.flush(); }
+
+        /**
+         * @brief Size of messages.log so far
+        */
+        streamoff size() { return messages.tellp(); }
+
+        void finish()
+        {
+            if (finished)
+                return;
+
+            finished = true;
+            messages.close();
+            AssertLong(!messages.fail(), __FILE__, __LINE__, "Unable to write the viewer messages " + directory + "/messages.log");
+        }
+
+    private:
+        // A json string escaped like python's json.dump() does by default
+        static string quoted(string const& text) { return nlohmann::json(text).dump(-1, ' ', true); }
+}; //class viewer_log{}
+
+#endif //PANDEMIC_HOYA_2002_VIEWER_LOG_HPP
@@ -0,0 +1,85 @@
+#ifndef PANDEMIC_HOYA_2002_WEIGHTED_ROWS_HPP
+#define PANDEMIC_HOYA_2002_WEIGHTED_ROWS_HPP
+
+#include <vector>
+#include "cells/sevirds.hpp"
+
+using namespace std;
+
+/**
+ * Population weighted fields of the cells, the rows the aggregate time series and the convergence monitor
+ * add up. The row of a cell is its population followed by its other fields of visit_fields() times its
+ * population, and is only computed again when the cell changes state.
+*/
+class weighted_rows
+{
+    unsigned int num_fields = 0;
+    vector<double> rows; // One row per cell
+
+    public:
+        /**
+         * @brief Weighs the initial states of the cells
+         *
+         * @param num_cells Number of cells
+         * @param state Gives the state of the cell at an index
+        */
+        template <typename STATE>
+        void start(unsigned int num_cells, STATE&& state)
+        {
+            num_fields = 0;
+            if (num_cells > 0)
+                visit_fields(state(0), [&](double) { ++num_fields; });
+
+            rows.assign(num_cells * num_fields, 0);
+            for (unsigned int i = 0; i < num_cells; ++i)
+                weigh(i, state(i));
+        }
+
+        /**
+         * @brief Weighs the cells that changed state on a day again
+         *
+         * @param changed Has each cell changed state on the day?
+         * @param state Gives the state of the cell at an index
+        */
+        template <typename STATE>
+        void update(vector<char> const& changed, STATE&& state)
+        {
+            for (unsigned int i = 0; i < changed.size(); ++i)
+            {
+                if (changed[i])
+                    weigh(i, state(i));
+            }
+        }
+
+        unsigned int fields() const                  { return num_fields; }
+        double const* row(unsigned int cell) const   { return &rows[cell * num_fields]; }
+
+        /**
+         * @brief Adds the rows of every cell up
+         *
+         * @param totals Set to the population of the cells followed by the number of people in each other field
+        */
+        void sum(vector<double>& totals) const
+        {
+            totals.assign(num_fields, 0);
+            for (unsigned int i = 0; i < rows.size(); i += num_fields)
+            {
+                for (unsigned int f = 0; f < num_fields; ++f)
+                    totals[f] += rows[i + f];
+            }
+        }
+
+    private:
+        void weigh(unsigned int cell, sevirds const& state)
+        {
+            double* weighted = &rows[cell * num_fields];
+            unsigned int f   = 0;
+
+            visit_fields(state, [&](double value) {
+                weighted[f] = f == 0 ? value : value * weighted[0];
+                ++f;
+            });
+        }
+}; //class weighted_rows{}
+
+#endif //PANDEMIC_HOYA_2002_WEIGHTED_ROWS_HPP
@@ -0,0 +1,43 @@
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+/**
+ * Counts the heap allocations made by every thread of a test by replacing the global operator new.
+ * The replacement operators are only defined once per test as every test is a single translation unit.
+*/
+namespace allocation_counter
+{
+    inline atomic<unsigned long long>& total()
+    {
+        static atomic<unsigned long long> count{0};
+        return count;
+    }
+
+    /**
+     * @brief Number of allocations made so far
+     *
+     * @return unsigned long long
+    */
+    inline unsigned long long count() { return total().load(); }
+} // allocation_counter
+
+void* operator new(size_t size)
+{
+    allocation_counter::total().fetch_add(1, memory_order_relaxed);
+    if (void* memory = malloc(size == 0 ? 1 : size))
+        return memory;
+
+    throw bad_alloc{};
+}
+
+// Not inlined so the compiler doesn't see free() being called on what operator new returned
+[[gnu::noinline]] void operator delete(void* memory) noexcept         { free(memory); }
+[[gnu::noinline]] void operator delete(void* memory, size_t) noexcept { free(memory); }
+
+#endif // ALLOCATION_COUNTER_HPP
@@ -0,0 +1,84 @@
+// Checks that once the cells computed a first day, simulating a day allocates nothing, whether the CSR
+// engine or the parallel runner runs the simulation: a run of many days makes as many heap allocations
+// as a run of two. The logs are written nowhere, only the simulation is measured.
+//   allocation_test DEFAULT.json
+
+#include "allocation_counter.hpp"
+#include <iostream>
+#include <string>
+#include "../src/model/csr_engine.hpp"
+#include "../src/model/geographical_coupled.hpp"
+#include "../src/model/parallel_runner.hpp"
+#include "sample_scenario.hpp"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool passed, string const& what)
+{
+    cout << (passed ? "PASS " : "FAIL ") << what << endl;
+    failures += passed ? 0 : 1;
+}
+
+// Allocations made by a run of the CSR engine, once loaded
+static unsigned long long csr_allocations(float until, unsigned int threads, bool compact)
+{
+    ostream nowhere(nullptr);
+    csr_engine engine("allocation_test_scenario.json", threads, nowhere, nowhere, compact);
+
+    unsigned long long before = allocation_counter::count();
+    float stop_time           = engine.run_until(until);
+    unsigned long long after  = allocation_counter::count();
+
+    check(stop_time == until, "the CSR engine simulates every day until " + to_string((int)until));
+    return after - before;
+}
+
+// Allocations made by a run of the parallel runner, once loaded
+static unsigned long long parallel_allocations(float until, unsigned int threads, bool compact)
+{
+    ostream nowhere(nullptr);
+    geographical_coupled<float> coupled("", true);
+    coupled.add_cells_scenario("allocation_test_scenario.json");
+    parallel_runner<float> runner(coupled, threads, nowhere, nowhere, compact);
+
+    unsigned long long before = allocation_counter::count();
+    float stop_time           = runner.run_until(until);
+    unsigned long long after  = allocation_counter::count();
+
+    check(stop_time == until, "the parallel runner simulates every day until " + to_string((int)until));
+    return after - before;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: " << argv[0] << " DEFAULT.json" << endl;
+        return 2;
+    }
+
+    write_sample_scenario(argv[1], "allocation_test_scenario.json");
+    float until = 60;
+
+    for (bool compact : {false, true})
+    {
+        for (unsigned int threads : {1u, 3u})
+        {
+            string mode = " with " + to_string(threads) + " thread(s)" + (compact ? " (compact)" : "");
+
+            unsigned long long warm_up = csr_allocations(2, threads, compact);
+            unsigned long long run     = csr_allocations(until, threads, compact);
+            check(run == warm_up, "the CSR engine allocates nothing after day 1" + mode + " ("
+                                    + to_string(warm_up) + " allocations in 2 days, " + to_string(run) + " in " + to_string((int)until) + ")");
+
+            warm_up = parallel_allocations(2, threads, compact);
+            run     = parallel_allocations(until, threads, compact);
+            check(run == warm_up, "the parallel runner allocates nothing after day 1" + mode + " ("
+                                    + to_string(warm_up) + " allocations in 2 days, " + to_string(run) + " in " + to_string((int)until) + ")");
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+// Checks that forking the CSR engine and running the fork gives the same logs as a straight run,
+// that the branches of a branch_spec which change the simulation diverge from it, and that they only copy
+// the pages of cells they change.
+//   csr_fork_test DEFAULT.json
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "../src/model/branch_spec.hpp"
+#include "../src/model/csr_engine.hpp"
+#include "sample_scenario.hpp"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool passed, string const& what)
+{
+    cout << (passed ? "PASS " : "FAIL ") << what << endl;
+    failures += passed ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: " << argv[0] << " DEFAULT.json" << endl;
+        return 2;
+    }
+
+    write_sample_scenario(argv[1], "fork_test_scenario.json");
+
+    // The branch left as is runs last, after the others changed their copies of the shared states
+    ofstream("fork_test_branches.json") << R"({"fork_day": 40, "branches": [
+        {"name": "half_virulence", "scale_rates": {"virulence_rates": 0.5}},
+        {"name": "disobedient", "cells": ["35000000", "35000028"], "state": {"disobedient": 0.6}},
+        {"name": "as_is"}]})";
+
+    branch_spec spec = branch_spec::read("fork_test_branches.json");
+    float until      = 100;
+
+    for (bool compact : {false, true})
+    {
+        string mode = compact ? " (compact)" : "";
+
+        ostringstream straight_state, straight_messages;
+        csr_engine straight("fork_test_scenario.json", 2, straight_state, straight_messages, compact);
+        straight.run_until(until);
+
+        ostringstream trunk_state, trunk_messages;
+        csr_engine trunk("fork_test_scenario.json", 2, trunk_state, trunk_messages, compact);
+        trunk.run_until(spec.fork_day);
+
+        map<string, string> branch_states;
+        for (simulation_branch const& branch : spec.branches)
+        {
+            ostringstream branch_state, branch_messages;
+            unique_ptr<csr_engine> fork = trunk.fork(branch_state, branch_messages);
+            branch.apply(*fork);
+            fork->run_until(until);
+
+            branch_states[branch.name] = branch_state.str();
+            if (branch.name == "as_is")
+            {
+                check(trunk_state.str() + branch_state.str() == straight_state.str(), "the state log of fork + run is that of the straight run" + mode);
+                check(trunk_messages.str() + branch_messages.str() == straight_messages.str(), "the messages of fork + run are those of the straight run" + mode);
+            }
+        }
+
+        check(branch_states.at("half_virulence") != branch_states.at("as_is"), "scaling the virulence rates diverges" + mode);
+        check(branch_states.at("disobedient") != branch_states.at("as_is"), "changing the disobedient people of some cells diverges" + mode);
+    }
+
+    // With a few pages of cells, a branch only copies the pages of the cells it changes
+    write_sample_scenario(argv[1], "fork_test_pages.json", 4 * csr_engine::page_size);
+
+    ostringstream trunk_state, trunk_messages;
+    csr_engine trunk("fork_test_pages.json", 2, trunk_state, trunk_messages);
+    trunk.run_until(spec.fork_day);
+
+    for (simulation_branch const& branch : spec.branches)
+    {
+        ostringstream branch_state, branch_messages;
+        unique_ptr<csr_engine> fork = trunk.fork(branch_state, branch_messages);
+        check(fork->shared_pages() == 4, "a fork shares every page of cells of the engine it is forked from (" + branch.name + ")");
+
+        // The cells of the disobedient branch are both in the first page
+        branch.apply(*fork);
+        unsigned int shared = branch.name == "as_is" ? 4 : branch.name == "disobedient" ? 3 : 0;
+        check(fork->shared_pages() == shared, "the branch " + branch.name + " copies only the pages of the cells it changes");
+    }
+
+    return failures == 0 ? 0 : 1;
+}
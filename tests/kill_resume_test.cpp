@@ -0,0 +1,146 @@
+// Checks that a simulation killed right after publishing a checkpoint resumes from it: the logs it left
+// on disk hold at least what the checkpoint saved, and once resumed they are those of a straight run,
+// whether the text logs are written by background threads or the states go to a binary log.
+//   kill_resume_test DEFAULT.json
+
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include "../src/model/csr_engine.hpp"
+#include "../src/model/Helpers/async_log_stream.hpp"
+#include "sample_scenario.hpp"
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool passed, string const& what)
+{
+    cout << (passed ? "PASS " : "FAIL ") << what << endl;
+    failures += passed ? 0 : 1;
+}
+
+struct logging
+{
+    string name;
+    bool async;  // Are the text logs written by background threads?
+    bool binary; // Do the states go to a binary log?
+};
+
+// Runs the sample scenario writing every log next to prefix, from a checkpoint if one is given
+static void simulate(logging const& logs, string const& prefix, float until, checkpoint const* resumed, unsigned int checkpoint_every)
+{
+    auto kept = [&](string const& log) { return resumed ? resumed->log_size(log, log) : streamoff(-1); };
+
+    ofstream state_file, messages_file;
+    open_continued(state_file, prefix + "_state.txt", kept("state"));
+    open_continued(messages_file, prefix + "_messages.txt", kept("messages"));
+
+    unique_ptr<async_log_stream> async_state, async_messages;
+    if (logs.async)
+    {
+        async_state    = make_unique<async_log_stream>(state_file);
+        async_messages = make_unique<async_log_stream>(messages_file);
+    }
+
+    mkdir((prefix + "_viewer").c_str(), 0755);
+    viewer_log viewer(prefix + "_viewer", kept("viewer"));
+    aggregate_log aggregates(prefix + "_aggregates.csv", kept("aggregates"));
+
+    unique_ptr<binary_state_log> binary_log;
+    if (logs.binary && resumed)
+        binary_log = make_unique<binary_state_log>(prefix + "_states.bin", false, resumed->binary_log_days, kept("binary_log"));
+    else if (logs.binary)
+        binary_log = make_unique<binary_state_log>(prefix + "_states.bin");
+
+    checkpoint_writer checkpoints(prefix + "_checkpoint.bin");
+
+    csr_engine engine("kill_test_scenario.json", 2, async_state ? *async_state : static_cast<ostream&>(state_file),
+                        async_messages ? *async_messages : static_cast<ostream&>(messages_file));
+    engine.use_viewer_log(viewer);
+    engine.use_aggregate_log(aggregates);
+    if (binary_log)
+        engine.use_binary_state_log(*binary_log);
+    if (checkpoint_every > 0)
+        engine.use_checkpoints(checkpoints, checkpoint_every);
+    if (resumed)
+        engine.resume(*resumed);
+
+    engine.run_until(until);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: " << argv[0] << " DEFAULT.json" << endl;
+        return 2;
+    }
+
+    write_sample_scenario(argv[1], "kill_test_scenario.json");
+
+    for (logging const& logs : {logging{"text logs", false, false}, logging{"async text logs", true, false},
+                                logging{"binary log", false, true}})
+    {
+        string killed = "kill_test_killed", straight = "kill_test_straight";
+        remove((killed + "_checkpoint.bin").c_str());
+
+        // The simulation is killed as soon as its first checkpoint is published, long before its end
+        pid_t child = fork();
+        if (child == 0)
+        {
+            simulate(logs, killed, 1e6, nullptr, 20);
+            _exit(0);
+        }
+
+        bool exited = false;
+        while (!exited && !ifstream(killed + "_checkpoint.bin").is_open())
+        {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            exited = waitpid(child, nullptr, WNOHANG) == child;
+        }
+
+        if (!exited)
+        {
+            kill(child, SIGKILL);
+            waitpid(child, nullptr, 0);
+        }
+        check(!exited, "the simulation is killed after its first checkpoint (" + logs.name + ")");
+        if (exited)
+            continue;
+
+        checkpoint saved = checkpoint::read(killed + "_checkpoint.bin");
+        float until      = saved.time + 30;
+
+        try
+        {
+            simulate(logs, killed, until, &saved, 0);
+            check(true, "the killed simulation resumes from its checkpoint (" + logs.name + ")");
+        }
+        catch (exception const& error)
+        {
+            check(false, "the killed simulation resumes from its checkpoint (" + logs.name + "): " + error.what());
+            continue;
+        }
+
+        simulate(logs, straight, until, nullptr, 0);
+
+        for (string log : {"_state.txt", "_messages.txt", "_viewer/messages.log", "_aggregates.csv", "_states.bin"})
+        {
+            if (log == "_states.bin" && !logs.binary)
+                continue;
+
+            check(read_file(killed + log) == read_file(straight + log), "the resumed " + log.substr(1) + " is that of the straight run (" + logs.name + ")");
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
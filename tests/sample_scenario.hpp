@@ -0,0 +1,75 @@
+#ifndef PANDEMIC_HOYA_2002_SAMPLE_SCENARIO_HPP
+#define PANDEMIC_HOYA_2002_SAMPLE_SCENARIO_HPP
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <nlohmann/json.hpp>
+
+using namespace std;
+
+/**
+ * @brief Writes a small scenario for the tests from the default.json of the Input_Generator: a ring of
+ * cells, each also neighbor of the cell three further, with some people exposed in one cell out of four
+ *
+ * @param default_path Path to Scripts/Input_Generator/ontario/default.json
+ * @param scenario_path Path of the scenario to write
+ * @param num_cells Number of cells of the scenario
+*/
+inline void write_sample_scenario(string const& default_path, string const& scenario_path, unsigned int num_cells=12)
+{
+    ifstream file(default_path);
+    if (!file.is_open())
+        throw runtime_error{"Unable to open the file: " + default_path};
+
+    nlohmann::json defaults;
+    file >> defaults;
+
+    nlohmann::json const& default_cell = defaults.at("default");
+    nlohmann::json const& correction   = default_cell.at("neighborhood").at("default_cell_id").at("infection_correction_factors");
+
+    auto id = [](unsigned int i) { return to_string(35000000 + 7 * i); };
+
+    nlohmann::json cells = {{"default", default_cell}};
+    for (unsigned int i = 0; i < num_cells; ++i)
+    {
+        nlohmann::json state = default_cell.at("state");
+        state["population"]  = 1000 + 250 * i;
+
+        if (i % 4 == 0)
+        {
+            for (unsigned int age = 0; age < 2; ++age)
+            {
+                state["susceptible"][age][0] = 0.5;
+                state["exposed"][age][0]     = 0.5;
+            }
+        }
+
+        nlohmann::json neighborhood;
+        neighborhood[id(i)]                               = {{"correlation", 1}, {"infection_correction_factors", correction}};
+        neighborhood[id((i + 1) % num_cells)]             = {{"correlation", 0.4}, {"infection_correction_factors", correction}};
+        neighborhood[id((i + num_cells - 1) % num_cells)] = {{"correlation", 0.4}, {"infection_correction_factors", correction}};
+        neighborhood[id((i + 3) % num_cells)]             = {{"correlation", 0.1}, {"infection_correction_factors", correction}};
+
+        cells[id(i)] = {{"state", state}, {"neighborhood", neighborhood}};
+    }
+
+    ofstream scenario(scenario_path);
+    scenario << nlohmann::json{{"cells", cells}};
+    if (!scenario)
+        throw runtime_error{"Unable to write the file: " + scenario_path};
+}
+
+/**
+ * @brief Whole content of a file, to compare logs
+*/
+inline string read_file(string const& path)
+{
+    ifstream file(path, ios::binary);
+    stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+#endif //PANDEMIC_HOYA_2002_SAMPLE_SCENARIO_HPP